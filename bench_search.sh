@@ -0,0 +1,85 @@
+#!/bin/bash
+# Throughput of the DNA search engines on synthetic inputs from dna_gen,
+# swept over background kind, sequence length, pattern length and worker
+# count. Reports Gcell/s (positions x pattern bases per second of wall
+# time, best of the repetitions) and the speedup over plain prog2, and
+# checks that every engine reports the same best position and count;
+# exits 1 if any disagree. The q-gram filter engine only reports windows
+# of at least FILTER% identity (default 80), so it agrees as long as the
+# planted copy clears that bar.
+# Usage: ./bench_search.sh [repetitions]
+# Sweep lists (and MISMATCH, FILTER) can be overridden from the environment, e.g.
+#   SEQ_LENS="100000 1000000" PAT_LENS="32 300" WORKERS="1 4" ./bench_search.sh
+# Compile first:
+#   gcc -Wall -O2 prog2.c dna_ingest.c -o prog2 -lpthread
+#   gcc -Wall -O2 prog2a.c dna_ingest.c -o prog2a -lpthread
+#   gcc -Wall -O2 dna_gen.c -o dna_gen
+reps=${1:-3}
+kinds=${KINDS:-"uniform gc repeat"}
+seq_lens=${SEQ_LENS:-"100000 1000000"}
+pat_lens=${PAT_LENS:-"16 64 300 2000"}
+workers=${WORKERS:-"1 2 4"}
+mismatch=${MISMATCH:-0.05}
+filter=${FILTER:-80}
+dir=$(mktemp -d /tmp/dna_bench_XXXXXX)
+trap 'rm -rf "$dir"' EXIT
+
+# Engines: label and command prefix (sequence, pattern, workers follow)
+engines=(
+  "prog2|./prog2"
+  "prog2-generic|./prog2 --kernel generic"
+  "prog2-tiled|./prog2 --kernel tiled"
+  "prog2-early|./prog2 --early-abandon"
+  "prog2-thread|./prog2 --backend thread"
+  "prog2-filter|./prog2 --filter $filter"
+  "prog2a|./prog2a"
+)
+
+# Runs one engine $reps times; prints "<best ms> <position> <count>"
+run_engine() {
+  local cmd=$1 seq=$2 pat=$3 procs=$4 best="" out t0 t1 ms
+  for ((r = 0; r < reps; r++)); do
+    t0=$(date +%s%N)
+    out=$($cmd "$seq" "$pat" "$procs" 2> /dev/null) || { echo "failed - -"; return; }
+    t1=$(date +%s%N)
+    ms=$(awk -v a="$t0" -v b="$t1" 'BEGIN { printf "%.3f", (b - a) / 1e6 }')
+    if [ -z "$best" ] || awk -v x="$ms" -v y="$best" 'BEGIN { exit !(x < y) }'; then best=$ms; fi
+  done
+  echo "$best $(echo "$out" | awk '/Best Match Position/ { p = $4 } /Best Match Count/ { c = $4 }
+                                    END { print p, c }')"
+}
+
+disagree=0
+printf "%-8s %8s %6s %3s %-14s %10s %8s %8s %9s %6s\n" \
+  kind seq pat P engine ms Gcell/s speedup position count
+for kind in $kinds; do
+  for n in $seq_lens; do
+    for m in $pat_lens; do
+      [ "$m" -le "$n" ] || continue
+      planted=$(./dna_gen --kind "$kind" --mismatch "$mismatch" --seed "$n$m" \
+                "$n" "$m" "$dir/seq.txt" "$dir/pat.txt") || exit 1
+      for p in $workers; do
+        ref=""
+        base=""
+        for e in "${engines[@]}"; do
+          label=${e%%|*}
+          read -r ms pos cnt <<< "$(run_engine "${e#*|}" "$dir/seq.txt" "$dir/pat.txt" "$p")"
+          gcells=$(awk -v n="$n" -v m="$m" -v t="$ms" \
+                   'BEGIN { printf "%.3f", (t > 0 ? n * m / (t * 1e6) : 0) }')
+          [ -n "$base" ] || base=$ms
+          speedup=$(awk -v b="$base" -v t="$ms" 'BEGIN { printf "%.2f", (t > 0 ? b / t : 0) }')
+          printf "%-8s %8d %6d %3d %-14s %10s %8s %8s %9s %6s\n" \
+            "$kind" "$n" "$m" "$p" "$label" "$ms" "$gcells" "$speedup" "$pos" "$cnt"
+          if [ -z "$ref" ]; then
+            ref="$pos $cnt"
+          elif [ "$pos $cnt" != "$ref" ]; then
+            echo "DISAGREE: $label gave $pos $cnt, expected $ref" >&2
+            disagree=1
+          fi
+        done
+      done
+      echo "# $kind n=$n m=$m $planted (position, matching bases)"
+    done
+  done
+done
+exit $disagree
@@ -0,0 +1,36 @@
+#!/bin/bash
+# Latency of one-shot prog2 runs vs. queries to a resident prog2 --serve.
+# Usage: ./bench_server.sh <seq_file> <subseq_file> <num_procs> [iterations]
+# Compile first: gcc -Wall -O2 prog2.c dna_ingest.c -o prog2 -lpthread
+seq_file=$1
+subseq_file=$2
+procs=$3
+iters=${4:-100}
+sock=/tmp/prog2_bench_$$.sock
+
+# p50/p99 of the millisecond values on stdin
+percentiles() {
+  sort -n | awk '{ v[NR] = $1 } END {
+    i50 = int((NR - 1) * 0.50) + 1; i99 = int((NR - 1) * 0.99) + 1
+    printf "p50=%.3f ms  p99=%.3f ms\n", v[i50], v[i99] }'
+}
+
+printf "one-shot:  "
+for ((i = 0; i < iters; i++)); do
+  t0=$(date +%s%N)
+  ./prog2 "$seq_file" "$subseq_file" "$procs" > /dev/null
+  t1=$(date +%s%N)
+  awk -v a="$t0" -v b="$t1" 'BEGIN { printf "%.3f\n", (b - a) / 1e6 }'
+done | percentiles
+
+./prog2 --serve "$seq_file" "$sock" "$procs" 2> /dev/null &
+server=$!
+while [ ! -S "$sock" ]; do sleep 0.05; done
+sleep 0.1
+
+printf "server:    "
+./prog2 --client "$sock" "$subseq_file" "$iters" |
+  awk '/p50/ { p50 = $3 } /p99/ { p99 = $3 } END { printf "p50=%s ms  p99=%s ms\n", p50, p99 }'
+
+kill -INT "$server"
+wait "$server"
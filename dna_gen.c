@@ -0,0 +1,185 @@
+/**********************************************************************
+File: dna_gen.c
+Author: Sean Anderson
+Brief: Synthetic inputs for benchmarking prog2/prog2a. Writes a sequence
+       (60 bases per line) and a pattern, and prints where the pattern
+       was planted. Background kinds:
+         uniform   independent bases, 25% each
+         gc        independent bases with GC fraction --gc (default 0.65)
+         repeat    tandem copies of a random unit (--unit bases, default
+                   250) with 1% point divergence per copy, so many
+                   positions score alike and tie-breaking is exercised
+       The pattern is drawn at random (for repeat, copied from a random
+       spot of the sequence) and planted at --plant (default: middle of
+       the sequence) with each base changed with probability --mismatch
+       (default 0.05). Output is deterministic for a --seed.
+Usage: dna_gen [--kind K] [--gc F] [--unit N] [--plant POS]
+               [--mismatch R] [--seed S] <seq_len> <pattern_len>
+               <seq_file> <pattern_file>
+Compile by: gcc -Wall -O2 dna_gen.c -o dna_gen
+Compiler: gcc
+***********************************************************************/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LINE_BASES  60
+
+// xorshift64* generator: fast, and the same stream on every platform
+static uint64_t rng_state = 88172645463325252ull;
+
+static uint64_t rng_next(void) {
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return rng_state * 2685821657736338717ull;
+}
+
+// Uniform double in [0, 1)
+static double rng_unit(void) {
+    return (double)(rng_next() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// Base with the given GC fraction (0.5 gives uniform)
+static char random_base(double gc) {
+    double u = rng_unit();
+    if (u < gc) return u < gc / 2 ? 'G' : 'C';
+    return u < gc + (1.0 - gc) / 2 ? 'A' : 'T';
+}
+
+// A different base than c
+static char mutate_base(char c) {
+    static const char bases[4] = { 'A', 'C', 'G', 'T' };
+    char m;
+    do {
+        m = bases[rng_next() >> 62];
+    } while (m == c);
+    return m;
+}
+
+// Writes n bases in lines of LINE_BASES; returns 0 or 1 on error
+static int write_lines(const char *fname, const char *bases, size_t n) {
+    FILE *f = fopen(fname, "w");
+    if (!f) {
+        perror(fname);
+        return 1;
+    }
+    for (size_t i = 0; i < n; i += LINE_BASES) {
+        size_t len = n - i < LINE_BASES ? n - i : LINE_BASES;
+        fwrite(bases + i, 1, len, f);
+        fputc('\n', f);
+    }
+    if (fclose(f) != 0) {
+        perror(fname);
+        return 1;
+    }
+    return 0;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [--kind uniform|gc|repeat] [--gc F] [--unit N] [--plant POS]\n"
+                    "          [--mismatch R] [--seed S] <seq_len> <pattern_len> <seq_file> "
+                    "<pattern_file>\n", prog);
+}
+
+int main(int argc, char *argv[]) {
+    const char *kind = "uniform";
+    double gc = 0.65;
+    size_t unit = 250;
+    long long plant = -1;
+    double mismatch = 0.05;
+    uint64_t seed = 1;
+    char *pos_args[4];
+    int npos = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--kind") == 0 && i + 1 < argc) {
+            kind = argv[++i];
+        } else if (strcmp(argv[i], "--gc") == 0 && i + 1 < argc) {
+            gc = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--unit") == 0 && i + 1 < argc) {
+            unit = (size_t)atol(argv[++i]);
+        } else if (strcmp(argv[i], "--plant") == 0 && i + 1 < argc) {
+            plant = atoll(argv[++i]);
+        } else if (strcmp(argv[i], "--mismatch") == 0 && i + 1 < argc) {
+            mismatch = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = (uint64_t)strtoull(argv[++i], NULL, 10);
+        } else if (strncmp(argv[i], "--", 2) != 0 && npos < 4) {
+            pos_args[npos++] = argv[i];
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (npos != 4) {
+        usage(argv[0]);
+        return 1;
+    }
+    long long seq_len = atoll(pos_args[0]);
+    long long pat_len = atoll(pos_args[1]);
+    if (seq_len <= 0 || pat_len <= 0 || pat_len > seq_len) {
+        fprintf(stderr, "need 0 < pattern_len <= seq_len\n");
+        return 1;
+    }
+    if (gc < 0.0 || gc > 1.0 || mismatch < 0.0 || mismatch > 1.0 || unit == 0) {
+        fprintf(stderr, "--gc and --mismatch must be in [0,1], --unit positive\n");
+        return 1;
+    }
+    if (plant < 0) plant = (seq_len - pat_len) / 2;
+    if (plant > seq_len - pat_len) {
+        fprintf(stderr, "--plant must leave room for the pattern\n");
+        return 1;
+    }
+    rng_state ^= seed * 0x9E3779B97F4A7C15ull;
+    if (rng_state == 0) rng_state = 1;
+
+    char *seq = (char *)malloc((size_t)seq_len);
+    char *pat = (char *)malloc((size_t)pat_len);
+    if (!seq || !pat) {
+        perror("malloc failed");
+        free(seq);
+        free(pat);
+        return 1;
+    }
+
+    // Background
+    if (strcmp(kind, "uniform") == 0 || strcmp(kind, "gc") == 0) {
+        double frac = kind[0] == 'g' ? gc : 0.5;
+        for (long long i = 0; i < seq_len; i++) seq[i] = random_base(frac);
+    } else if (strcmp(kind, "repeat") == 0) {
+        for (size_t i = 0; i < unit && (long long)i < seq_len; i++) seq[i] = random_base(0.5);
+        for (long long i = (long long)unit; i < seq_len; i++)
+            seq[i] = rng_unit() < 0.01 ? mutate_base(seq[i - (long long)unit])
+                                       : seq[i - (long long)unit];
+    } else {
+        fprintf(stderr, "unknown kind '%s'\n", kind);
+        free(seq);
+        free(pat);
+        return 1;
+    }
+
+    // Pattern (for repeats, a copy of the repeat so it scores well
+    // everywhere), and its planted copy with point mismatches
+    long long src = (long long)(rng_next() % (uint64_t)(seq_len - pat_len + 1));
+    size_t planted_mismatches = 0;
+    for (long long j = 0; j < pat_len; j++) {
+        pat[j] = kind[0] == 'r' ? seq[src + j] : random_base(kind[0] == 'g' ? gc : 0.5);
+        char c = pat[j];
+        if (rng_unit() < mismatch) {
+            c = mutate_base(c);
+            planted_mismatches++;
+        }
+        seq[plant + j] = c;
+    }
+
+    int rc = write_lines(pos_args[2], seq, (size_t)seq_len) ||
+             write_lines(pos_args[3], pat, (size_t)pat_len);
+    if (rc == 0)
+        printf("planted %lld %zu\n", plant, (size_t)pat_len - planted_mismatches);
+    free(seq);
+    free(pat);
+    return rc;
+}
@@ -0,0 +1,683 @@
+/**********************************************************************
+File: dna_ingest.c
+Author: Sean Anderson
+Brief: Shared DNA input reader (see dna_ingest.h). Files are read in
+       64KB chunks; each chunk is classified 16 bytes at a time, and
+       all-valid blocks (the common case between line breaks) are
+       uppercased and stored with one vector store. FASTA header lines
+       (a '>' at the start of a line) are found with memchr and skipped,
+       so plain files pay only the '>' search per chunk. IUPAC input is translated to base-set masks
+       through two 16-entry tables, 16 bytes per byte shuffle on CPUs
+       with SSSE3 (checked at run time).
+Compile by: gcc -Wall -O2 -c dna_ingest.c (linked into prog2/prog2a)
+***********************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "dna_ingest.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#ifdef __x86_64__
+#include <tmmintrin.h>   // pshufb in target("ssse3") functions
+#endif
+
+// Raw bytes read per chunk
+#define INGEST_CHUNK 65536
+
+// Growing output of one ingest call: ASCII bases or 2-bit words, plus
+// FASTA parser state carried across chunks
+typedef struct {
+    char     *ascii;
+    uint64_t *packed;
+    size_t    cap;       // bases the output can hold
+    size_t    keep;      // bases stored so far
+    size_t    max_keep;
+    int       in_header; // inside a '>' line
+    int       line_start;// the previous chunk ended with a newline
+    int       name_done; // header name ended at whitespace
+    size_t    name_len;
+    size_t    rec_cap;
+    dna_record_list_t records;
+    int       iupac;     // store IUPAC masks instead of A/C/G/T
+} ingest_out_t;
+
+// IUPAC masks for uppercase letters 0x40-0x4F and 0x50-0x5F (the two
+// shuffle tables), indexed by the low nibble
+#define M_A DNA_MASK_A
+#define M_C DNA_MASK_C
+#define M_G DNA_MASK_G
+#define M_T DNA_MASK_T
+static const unsigned char iupac_lo4[16] = {
+    0,       M_A,             M_C | M_G | M_T, M_C,         // @ A B C
+    M_A | M_G | M_T, 0,       0,               M_G,         // D E F G
+    M_A | M_C | M_T, 0,       0,               M_G | M_T,   // H I J K
+    0,       M_A | M_C,       M_A | M_C | M_G | M_T, 0      // L M N O
+};
+static const unsigned char iupac_lo5[16] = {
+    0,       0,               M_A | M_G,       M_C | M_G,   // P Q R S
+    M_T,     M_T,             M_A | M_C | M_G, M_A | M_T,   // T U V W
+    0,       M_C | M_T,       0,               0,           // X Y Z [
+    0,       0,               0,               0
+};
+
+// Monotonic clock in seconds
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// Keeps the A/C/G/T bytes of src (uppercased) at dst; dst needs room for
+// n bytes. Returns the number kept.
+static size_t compact_chunk(const char *src, size_t n, char *dst) {
+    size_t keep = 0;
+    size_t i = 0;
+
+#ifdef __SSE2__
+    const __m128i upper = _mm_set1_epi8((char)0xDF);
+    const __m128i a = _mm_set1_epi8('A');
+    const __m128i c = _mm_set1_epi8('C');
+    const __m128i g = _mm_set1_epi8('G');
+    const __m128i t = _mm_set1_epi8('T');
+    for (; i + 16 <= n; i += 16) {
+        // Clearing bit 5 uppercases letters; only 'A'/'a' map to 'A' etc.
+        __m128i u = _mm_and_si128(_mm_loadu_si128((const __m128i *)(src + i)), upper);
+        __m128i ok = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(u, a), _mm_cmpeq_epi8(u, c)),
+                                  _mm_or_si128(_mm_cmpeq_epi8(u, g), _mm_cmpeq_epi8(u, t)));
+        unsigned mask = (unsigned)_mm_movemask_epi8(ok);
+        if (mask == 0xFFFFu) {
+            _mm_storeu_si128((__m128i *)(dst + keep), u);
+            keep += 16;
+        } else {
+            while (mask) {
+                int b = __builtin_ctz(mask);
+                dst[keep++] = (char)(src[i + (size_t)b] & 0xDF);
+                mask &= mask - 1;
+            }
+        }
+    }
+#endif
+
+    for (; i < n; i++) {
+        char u = (char)(src[i] & 0xDF);
+        if (u == 'A' || u == 'C' || u == 'G' || u == 'T')
+            dst[keep++] = u;
+    }
+    return keep;
+}
+
+unsigned dna_iupac_mask(char c) {
+    unsigned char u = (unsigned char)c & 0xDF;
+    if ((u >> 4) == 4) return iupac_lo4[u & 15];
+    if ((u >> 4) == 5) return iupac_lo5[u & 15];
+    return 0;
+}
+
+// IUPAC version of compact_chunk: stores the mask of every nucleotide
+// code in src at dst and returns the number kept
+static size_t compact_iupac_scalar(const char *src, size_t n, char *dst) {
+    size_t keep = 0;
+    for (size_t i = 0; i < n; i++) {
+        unsigned m = dna_iupac_mask(src[i]);
+        if (m) dst[keep++] = (char)m;
+    }
+    return keep;
+}
+
+#ifdef __x86_64__
+// Shuffle version of compact_iupac_scalar, 16 codes per pair of pshufb
+static __attribute__((target("ssse3"))) size_t compact_iupac_ssse3(const char *src, size_t n,
+                                                                   char *dst) {
+    size_t keep = 0;
+    size_t i = 0;
+    const __m128i upper = _mm_set1_epi8((char)0xDF);
+    const __m128i lo_nib = _mm_set1_epi8(0x0F);
+    const __m128i hi4 = _mm_set1_epi8(0x40);
+    const __m128i hi5 = _mm_set1_epi8(0x50);
+    const __m128i t4 = _mm_loadu_si128((const __m128i *)iupac_lo4);
+    const __m128i t5 = _mm_loadu_si128((const __m128i *)iupac_lo5);
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= n; i += 16) {
+        __m128i u = _mm_and_si128(_mm_loadu_si128((const __m128i *)(src + i)), upper);
+        __m128i lo = _mm_and_si128(u, lo_nib);
+        __m128i hi = _mm_andnot_si128(lo_nib, u);
+        // Look the low nibble up in the table its high nibble selects
+        __m128i m = _mm_or_si128(
+            _mm_and_si128(_mm_cmpeq_epi8(hi, hi4), _mm_shuffle_epi8(t4, lo)),
+            _mm_and_si128(_mm_cmpeq_epi8(hi, hi5), _mm_shuffle_epi8(t5, lo)));
+        unsigned mask = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(m, zero)) ^ 0xFFFFu;
+        if (mask == 0xFFFFu) {
+            _mm_storeu_si128((__m128i *)(dst + keep), m);
+            keep += 16;
+        } else {
+            unsigned char tmp[16];
+            _mm_storeu_si128((__m128i *)tmp, m);
+            while (mask) {
+                int b = __builtin_ctz(mask);
+                dst[keep++] = (char)tmp[b];
+                mask &= mask - 1;
+            }
+        }
+    }
+    return keep + compact_iupac_scalar(src + i, n - i, dst + keep);
+}
+#endif
+
+// Picks the IUPAC compaction the CPU supports
+static size_t compact_iupac_chunk(const char *src, size_t n, char *dst) {
+#ifdef __x86_64__
+    if (__builtin_cpu_supports("ssse3")) return compact_iupac_ssse3(src, n, dst);
+#endif
+    return compact_iupac_scalar(src, n, dst);
+}
+
+// Makes room for 'more' bases; returns -1 if that passes max_keep
+static int out_reserve(ingest_out_t *o, size_t more) {
+    if (o->keep + more > o->max_keep) return -1;
+    if (o->keep + more <= o->cap) return 0;
+
+    size_t cap = o->cap ? o->cap : INGEST_CHUNK;
+    while (cap < o->keep + more) cap *= 2;
+    if (cap > o->max_keep) cap = o->max_keep;
+
+    if (o->packed) {
+        size_t words_old = o->cap / DNA_BASES_PER_WORD + 1;
+        size_t words = cap / DNA_BASES_PER_WORD + 1;
+        uint64_t *p = (uint64_t *)realloc(o->packed, words * sizeof(uint64_t));
+        if (!p) return -2;
+        memset(p + words_old, 0, (words - words_old) * sizeof(uint64_t));
+        o->packed = p;
+    } else {
+        char *p = (char *)realloc(o->ascii, cap + 1);
+        if (!p) return -2;
+        o->ascii = p;
+    }
+    o->cap = cap;
+    return 0;
+}
+
+// Appends 2-bit codes for n ASCII bases at the current end of the output
+static void out_pack(ingest_out_t *o, const char *bases, size_t n) {
+    for (size_t k = 0; k < n; k++) {
+        size_t idx = o->keep + k;
+        o->packed[idx / DNA_BASES_PER_WORD] |=
+            (uint64_t)dna_code(bases[k]) << (2 * (idx % DNA_BASES_PER_WORD));
+    }
+    o->keep += n;
+}
+
+// Appends the bases of one header-free span; returns 0, -1 when over
+// max_keep or -2 when out of memory
+static int out_append(ingest_out_t *o, const char *src, size_t n, char *bounce) {
+    // Compact in place when the output surely has room, else bounce
+    size_t (*compact)(const char *, size_t, char *) =
+        o->iupac ? compact_iupac_chunk : compact_chunk;
+    if (!o->packed && o->cap - o->keep >= n) {
+        o->keep += compact(src, n, o->ascii + o->keep);
+        return 0;
+    }
+    size_t got = compact(src, n, bounce);
+    int r = out_reserve(o, got);
+    if (r != 0) return r;
+    if (o->packed) {
+        out_pack(o, bounce, got);
+    } else {
+        memcpy(o->ascii + o->keep, bounce, got);
+        o->keep += got;
+    }
+    return 0;
+}
+
+// Closes the current FASTA record and opens a new one at the output end
+static int record_begin(ingest_out_t *o) {
+    dna_record_list_t *l = &o->records;
+    if (l->count > 0)
+        l->recs[l->count - 1].length = o->keep - l->recs[l->count - 1].start;
+    if (l->count == o->rec_cap) {
+        size_t cap = o->rec_cap ? o->rec_cap * 2 : 16;
+        dna_record_t *p = (dna_record_t *)realloc(l->recs, cap * sizeof(dna_record_t));
+        if (!p) return -2;
+        l->recs = p;
+        o->rec_cap = cap;
+    }
+    dna_record_t *r = &l->recs[l->count++];
+    memset(r, 0, sizeof(*r));
+    r->start = o->keep;
+    o->name_done = 0;
+    o->name_len = 0;
+    return 0;
+}
+
+// Adds header text to the current record's name, which ends at the
+// first whitespace
+static void header_name_append(ingest_out_t *o, const char *p, size_t n) {
+    dna_record_t *r = &o->records.recs[o->records.count - 1];
+    for (size_t i = 0; i < n && !o->name_done; i++) {
+        char c = p[i];
+        if (c == ' ' || c == '\t' || c == '\r') {
+            o->name_done = o->name_len > 0;
+            continue;
+        }
+        if (o->name_len + 1 < DNA_NAME_MAX) r->name[o->name_len++] = c;
+    }
+}
+
+// Streams fname into o; returns 0, or -1 after printing the error
+static int ingest(const char *fname, ingest_out_t *o, dna_ingest_stats_t *stats) {
+    double t0 = now_sec();
+    int fd = open(fname, O_RDONLY);
+    if (fd == -1) {
+        perror("fopen failed");
+        return -1;
+    }
+
+    // Start at the file size (or the cap) so regular files need no regrowth
+    struct stat st;
+    size_t hint = INGEST_CHUNK;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) hint = (size_t)st.st_size;
+    if (hint > o->max_keep) hint = o->max_keep;
+    if (out_reserve(o, hint) != 0 && hint > 0) {
+        perror("malloc failed");
+        close(fd);
+        return -1;
+    }
+
+    char *raw = (char *)malloc(INGEST_CHUNK);
+    char *bounce = (char *)malloc(INGEST_CHUNK);
+    if (!raw || !bounce) {
+        perror("malloc failed");
+        free(raw);
+        free(bounce);
+        close(fd);
+        return -1;
+    }
+
+    size_t bytes = 0;
+    int rc = 0;
+    o->line_start = 1;
+    for (;;) {
+        ssize_t n = read(fd, raw, INGEST_CHUNK);
+        if (n == 0) break;
+        if (n < 0) {
+            perror("fread failed");
+            rc = -1;
+            break;
+        }
+        bytes += (size_t)n;
+
+        // Alternate between header lines and the base spans between them
+        const char *p = raw;
+        const char *end = raw + n;
+        while (p < end && rc == 0) {
+            if (o->in_header) {
+                const char *nl = (const char *)memchr(p, '\n', (size_t)(end - p));
+                const char *stop = nl ? nl : end;
+                header_name_append(o, p, (size_t)(stop - p));
+                if (nl) o->in_header = 0;
+                p = nl ? nl + 1 : end;
+                continue;
+            }
+            // Only a '>' that starts a line opens a header; any other is
+            // dropped with the rest of the non-bases
+            const char *gt = p;
+            while ((gt = (const char *)memchr(gt, '>', (size_t)(end - gt))) != NULL &&
+                   !(gt == raw ? o->line_start : gt[-1] == '\n'))
+                gt++;
+            const char *stop = gt ? gt : end;
+            int r = out_append(o, p, (size_t)(stop - p), bounce);
+            if (r == 0 && gt) r = record_begin(o);
+            if (r == -1) {
+                fprintf(stderr, "file '%s' too big after filtering (max %zu)\n",
+                        fname, o->max_keep);
+                rc = -1;
+            } else if (r == -2) {
+                perror("malloc failed");
+                rc = -1;
+            }
+            if (gt) o->in_header = 1;
+            p = gt ? gt + 1 : end;
+        }
+        if (rc != 0) break;
+        o->line_start = raw[n - 1] == '\n';
+    }
+    free(raw);
+    free(bounce);
+    close(fd);
+
+    if (o->records.count > 0)
+        o->records.recs[o->records.count - 1].length =
+            o->keep - o->records.recs[o->records.count - 1].start;
+    if (rc == 0 && o->ascii) o->ascii[o->keep] = '\0';
+    if (stats) {
+        stats->bytes_in = bytes;
+        stats->bases_out = o->keep;
+        stats->seconds = now_sec() - t0;
+    }
+    return rc;
+}
+
+ssize_t dna_ingest_file(const char *fname, size_t max_keep, char **out,
+                        dna_ingest_stats_t *stats) {
+    return dna_ingest_fasta(fname, max_keep, out, stats, NULL);
+}
+
+ssize_t dna_ingest_fasta(const char *fname, size_t max_keep, char **out,
+                         dna_ingest_stats_t *stats, dna_record_list_t *records) {
+    ingest_out_t o;
+    memset(&o, 0, sizeof(o));
+    o.max_keep = max_keep;
+    o.ascii = (char *)malloc(1);
+    if (!o.ascii) {
+        perror("malloc failed");
+        return -1;
+    }
+    if (ingest(fname, &o, stats) != 0) {
+        free(o.ascii);
+        free(o.records.recs);
+        return -1;
+    }
+    *out = o.ascii;
+    if (records)
+        *records = o.records;
+    else
+        free(o.records.recs);
+    return (ssize_t)o.keep;
+}
+
+ssize_t dna_ingest_iupac(const char *fname, size_t max_keep, char **out,
+                         dna_ingest_stats_t *stats, dna_record_list_t *records) {
+    ingest_out_t o;
+    memset(&o, 0, sizeof(o));
+    o.max_keep = max_keep;
+    o.iupac = 1;
+    o.ascii = (char *)malloc(1);
+    if (!o.ascii) {
+        perror("malloc failed");
+        return -1;
+    }
+    if (ingest(fname, &o, stats) != 0) {
+        free(o.ascii);
+        free(o.records.recs);
+        return -1;
+    }
+    *out = o.ascii;
+    if (records)
+        *records = o.records;
+    else
+        free(o.records.recs);
+    return (ssize_t)o.keep;
+}
+
+ssize_t dna_ingest_file_2bit(const char *fname, size_t max_keep, uint64_t **out,
+                             dna_ingest_stats_t *stats) {
+    ingest_out_t o;
+    memset(&o, 0, sizeof(o));
+    o.max_keep = max_keep;
+    o.packed = (uint64_t *)calloc(1, sizeof(uint64_t));
+    if (!o.packed) {
+        perror("malloc failed");
+        return -1;
+    }
+    int rc = ingest(fname, &o, stats);
+    free(o.records.recs);
+    if (rc != 0) {
+        free(o.packed);
+        return -1;
+    }
+    *out = o.packed;
+    return (ssize_t)o.keep;
+}
+
+ssize_t dna_filter(const char *src, size_t n, char *dst, size_t max_keep) {
+    // Compacted output never exceeds its input, so full-size spans are safe
+    size_t keep = 0;
+    char bounce[4096];
+    while (n > 0) {
+        size_t take = n < sizeof(bounce) ? n : sizeof(bounce);
+        if (max_keep - keep >= take) {
+            keep += compact_chunk(src, take, dst + keep);
+        } else {
+            size_t got = compact_chunk(src, take, bounce);
+            if (keep + got > max_keep) return -1;
+            memcpy(dst + keep, bounce, got);
+            keep += got;
+        }
+        src += take;
+        n -= take;
+    }
+    dst[keep] = '\0';
+    return (ssize_t)keep;
+}
+
+size_t dna_filter_fasta(const char *src, size_t n, char *dst, int *state) {
+    size_t keep = 0;
+    if (n == 0) return 0;
+    const char *piece = src;
+    int line_start = *state == DNA_FASTA_LINE_START;
+    while (n > 0) {
+        if (*state == DNA_FASTA_HEADER) {
+            const char *nl = (const char *)memchr(src, '\n', n);
+            if (!nl) {
+                src += n;
+                break;
+            }
+            n -= (size_t)(nl + 1 - src);
+            src = nl + 1;
+            *state = DNA_FASTA_LINE_START;
+            continue;
+        }
+        // Only a '>' that starts a line opens a header
+        const char *gt = src;
+        while ((gt = (const char *)memchr(gt, '>', n - (size_t)(gt - src))) != NULL &&
+               !(gt == piece ? line_start : gt[-1] == '\n'))
+            gt++;
+        size_t span = gt ? (size_t)(gt - src) : n;
+        keep += compact_chunk(src, span, dst + keep);
+        src += span;
+        n -= span;
+        if (gt) *state = DNA_FASTA_HEADER;
+    }
+    if (*state != DNA_FASTA_HEADER)
+        *state = src[-1] == '\n' ? DNA_FASTA_LINE_START : DNA_FASTA_IN_LINE;
+    return keep;
+}
+
+void dna_pack_2bit(const char *bases, size_t n, uint64_t *packed) {
+    memset(packed, 0, (n / DNA_BASES_PER_WORD + 1) * sizeof(uint64_t));
+    for (size_t i = 0; i < n; i++)
+        packed[i / DNA_BASES_PER_WORD] |=
+            (uint64_t)dna_code(bases[i]) << (2 * (i % DNA_BASES_PER_WORD));
+}
+
+const dna_record_t *dna_record_at(const dna_record_list_t *records, size_t pos) {
+    // Records are in file order with ascending starts: binary search
+    size_t lo = 0, hi = records->count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (records->recs[mid].start <= pos) lo = mid + 1;
+        else hi = mid;
+    }
+    if (lo == 0) return NULL;
+    const dna_record_t *r = &records->recs[lo - 1];
+    return pos < r->start + r->length ? r : NULL;
+}
+
+int dna_fai_build(const char *fasta, const char *fai_path) {
+    FILE *in = fopen(fasta, "rb");
+    if (!in) {
+        perror("fopen failed");
+        return -1;
+    }
+    FILE *out = fopen(fai_path, "w");
+    if (!out) {
+        perror("fopen failed");
+        fclose(in);
+        return -1;
+    }
+
+    // Per record: residues, offset of the first residue, and the residue
+    // and byte widths of its lines (all but the last line must match)
+    char *line = NULL;
+    size_t line_cap = 0;
+    ssize_t len;
+    long long offset = 0;
+    char name[DNA_NAME_MAX] = "";
+    int in_rec = 0, short_seen = 0, rc = 0;
+    long long rec_len = 0, rec_off = 0, line_bases = 0, line_width = 0;
+
+    while (rc == 0 && (len = getline(&line, &line_cap, in)) != -1) {
+        long long bytes = len;
+        long long bases = len;
+        while (bases > 0 && (line[bases - 1] == '\n' || line[bases - 1] == '\r')) bases--;
+
+        if (line[0] == '>') {
+            if (in_rec)
+                fprintf(out, "%s\t%lld\t%lld\t%lld\t%lld\n", name, rec_len, rec_off,
+                        line_bases, line_width);
+            size_t k = 0;
+            for (long long i = 1; i < bases && k + 1 < sizeof(name); i++) {
+                if (line[i] == ' ' || line[i] == '\t') break;
+                name[k++] = line[i];
+            }
+            name[k] = '\0';
+            in_rec = 1;
+            short_seen = 0;
+            rec_len = 0;
+            rec_off = offset + bytes;
+            line_bases = line_width = 0;
+        } else if (in_rec && bases > 0) {
+            if (line_bases == 0) {
+                line_bases = bases;
+                line_width = bytes;
+            } else if (short_seen || bases > line_bases) {
+                fprintf(stderr, "'%s': record '%s' has uneven line lengths\n", fasta, name);
+                rc = -1;
+            }
+            // A shorter (or unterminated) line must be the record's last
+            if (bases < line_bases || bytes - bases != line_width - line_bases) short_seen = 1;
+            rec_len += bases;
+        }
+        offset += bytes;
+    }
+    if (rc == 0 && in_rec)
+        fprintf(out, "%s\t%lld\t%lld\t%lld\t%lld\n", name, rec_len, rec_off,
+                line_bases, line_width);
+    free(line);
+    fclose(in);
+    if (fclose(out) != 0 && rc == 0) {
+        perror("fclose failed");
+        rc = -1;
+    }
+    if (rc != 0) remove(fai_path);
+    return rc;
+}
+
+ssize_t dna_fai_fetch(const char *fasta, const char *name, size_t max_keep,
+                      char **out, dna_ingest_stats_t *stats) {
+    double t0 = now_sec();
+    char fai_path[4096];
+    snprintf(fai_path, sizeof(fai_path), "%s.fai", fasta);
+    FILE *fai = fopen(fai_path, "r");
+    if (!fai) {
+        fprintf(stderr, "no index '%s' (build it with --fasta-index)\n", fai_path);
+        return -1;
+    }
+
+    // Find the record's line in the index
+    char rec[DNA_NAME_MAX];
+    long long length = 0, offset = 0, line_bases = 0, line_width = 0;
+    int found = 0;
+    while (fscanf(fai, "%127s %lld %lld %lld %lld", rec, &length, &offset,
+                  &line_bases, &line_width) == 5) {
+        if (strcmp(rec, name) == 0) {
+            found = 1;
+            break;
+        }
+    }
+    fclose(fai);
+    if (!found) {
+        fprintf(stderr, "record '%s' not in '%s'\n", name, fai_path);
+        return -1;
+    }
+    if ((size_t)length > max_keep) {
+        fprintf(stderr, "record '%s' too big (max %zu)\n", name, max_keep);
+        return -1;
+    }
+
+    // Map just the record's bytes (from the page holding its offset):
+    // full lines plus the residues of a trailing partial line
+    size_t span = line_bases > 0
+        ? (size_t)(length / line_bases * line_width + length % line_bases) : 0;
+    long page = sysconf(_SC_PAGESIZE);
+    off_t map_off = (off_t)(offset - offset % page);
+    size_t lead = (size_t)(offset - map_off);
+
+    char *dst = (char *)malloc((size_t)length + 1);
+    if (!dst) {
+        perror("malloc failed");
+        return -1;
+    }
+    ssize_t keep = 0;
+    if (span > 0) {
+        int fd = open(fasta, O_RDONLY);
+        if (fd == -1) {
+            perror("open failed");
+            free(dst);
+            return -1;
+        }
+        struct stat st;
+        if (fstat(fd, &st) == -1) {
+            perror("fstat failed");
+            close(fd);
+            free(dst);
+            return -1;
+        }
+        // A stale index can point past the end of a since-shortened file
+        if ((long long)st.st_size <= offset) {
+            fprintf(stderr, "record '%s' does not match '%s'\n", name, fai_path);
+            close(fd);
+            free(dst);
+            return -1;
+        }
+        if ((long long)st.st_size < offset + (long long)span)
+            span = (size_t)(st.st_size - offset);   // last line without newline
+        char *map = (char *)mmap(NULL, lead + span, PROT_READ, MAP_PRIVATE, fd, map_off);
+        close(fd);
+        if (map == MAP_FAILED) {
+            perror("mmap failed");
+            free(dst);
+            return -1;
+        }
+        keep = dna_filter(map + lead, span, dst, (size_t)length);
+        munmap(map, lead + span);
+    } else {
+        dst[0] = '\0';
+    }
+    if (keep < 0) {
+        fprintf(stderr, "record '%s' does not match '%s'\n", name, fai_path);
+        free(dst);
+        return -1;
+    }
+    if (stats) {
+        stats->bytes_in = span;
+        stats->bases_out = (size_t)keep;
+        stats->seconds = now_sec() - t0;
+    }
+    *out = dst;
+    return keep;
+}
+
+double dna_ingest_rate(const dna_ingest_stats_t *stats) {
+    return stats->seconds > 0.0 ? (double)stats->bytes_in / stats->seconds : 0.0;
+}
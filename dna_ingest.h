@@ -0,0 +1,117 @@
+/**********************************************************************
+File: dna_ingest.h
+Author: Sean Anderson
+Brief: Shared DNA input reader for prog2.c and prog2a.c. Streams a file,
+       keeps only A/C/G/T (lowercase is uppercased, everything else such
+       as newlines is dropped) and returns either ASCII bases or 2-bit
+       packed codes. Classification and compaction use SSE2 when the
+       compiler targets it and a scalar loop otherwise. FASTA header
+       lines ('>' to end of line) are skipped and can be reported as
+       records; a samtools-style .fai index lets one contig be mapped
+       and filtered without reading the rest of the file. An IUPAC mode
+       keeps ambiguity codes (N, R, Y, ...) as 4-bit base-set masks.
+***********************************************************************/
+
+#ifndef DNA_INGEST_H
+#define DNA_INGEST_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+// Bases per packed word in 2-bit output
+#define DNA_BASES_PER_WORD 32
+
+// IUPAC base-set masks: a code matches another when their masks overlap
+#define DNA_MASK_A 1
+#define DNA_MASK_C 2
+#define DNA_MASK_G 4
+#define DNA_MASK_T 8
+
+// Longest record name kept (longer names are truncated)
+#define DNA_NAME_MAX 128
+
+// One FASTA record of an ingested file, in filtered-base coordinates
+typedef struct {
+    char   name[DNA_NAME_MAX];
+    size_t start;        // offset of the record's first base in the output
+    size_t length;       // bases kept for the record
+} dna_record_t;
+
+// Records found while ingesting (malloc'd array, free with free())
+typedef struct {
+    dna_record_t *recs;
+    size_t count;
+} dna_record_list_t;
+
+// Throughput figures for one ingest call
+typedef struct {
+    size_t bytes_in;     // raw bytes read from the file
+    size_t bases_out;    // bases kept after filtering
+    double seconds;      // wall time spent reading and filtering
+} dna_ingest_stats_t;
+
+// 2-bit code of an uppercase base: A=0 C=1 T=2 G=3 (bits 1-2 of ASCII)
+static inline unsigned dna_code(char c) {
+    return ((unsigned char)c >> 1) & 3u;
+}
+
+// Reads fname and keeps its A/C/G/T bases in a malloc'd NUL-terminated
+// buffer; returns the base count, or -1 (after printing why) on error or
+// when more than max_keep bases would be kept. stats may be NULL.
+ssize_t dna_ingest_file(const char *fname, size_t max_keep, char **out,
+                        dna_ingest_stats_t *stats);
+
+// Same as dna_ingest_file but also returns the file's FASTA records
+// (count 0 for a plain sequence file)
+ssize_t dna_ingest_fasta(const char *fname, size_t max_keep, char **out,
+                         dna_ingest_stats_t *stats, dna_record_list_t *records);
+
+// Same as dna_ingest_fasta but keeps every IUPAC nucleotide code (U is
+// read as T) and stores each as its DNA_MASK_* set, e.g. N = 15, R = A|G.
+// Positions therefore line up with the file's residues. records may be NULL.
+ssize_t dna_ingest_iupac(const char *fname, size_t max_keep, char **out,
+                         dna_ingest_stats_t *stats, dna_record_list_t *records);
+
+// Mask for one IUPAC character (either case), 0 for anything else
+unsigned dna_iupac_mask(char c);
+
+// Same as dna_ingest_file but packs straight to 2-bit codes, base i in
+// bits 2*(i%32) of word i/32. One zero word of padding follows the data.
+ssize_t dna_ingest_file_2bit(const char *fname, size_t max_keep, uint64_t **out,
+                             dna_ingest_stats_t *stats);
+
+// Filters n bytes of src into dst (room for max_keep + 1) and
+// NUL-terminates it; returns the base count or -1 if over max_keep
+ssize_t dna_filter(const char *src, size_t n, char *dst, size_t max_keep);
+
+// Parser states of dna_filter_fasta
+#define DNA_FASTA_LINE_START 0
+#define DNA_FASTA_IN_LINE    1
+#define DNA_FASTA_HEADER     2
+
+// Like dna_filter but also skips FASTA header lines (a '>' at the start
+// of a line, to the end of that line); *state carries the parser state
+// between consecutive pieces of one file (start at DNA_FASTA_LINE_START
+// on a line start). dst needs room for n bytes; returns the base count.
+size_t dna_filter_fasta(const char *src, size_t n, char *dst, int *state);
+
+// Packs n ASCII bases into 2-bit words (ceil(n/32) + 1 words, zeroed)
+void dna_pack_2bit(const char *bases, size_t n, uint64_t *packed);
+
+// Finds the record holding filtered position pos (NULL if none)
+const dna_record_t *dna_record_at(const dna_record_list_t *records, size_t pos);
+
+// Writes a samtools-style index (name, length, offset, line bases, line
+// width per record) for fasta to fai_path; returns 0 or -1 on error
+int dna_fai_build(const char *fasta, const char *fai_path);
+
+// Looks name up in fasta's .fai, maps only that record's bytes and
+// filters them like dna_ingest_file; returns the base count or -1
+ssize_t dna_fai_fetch(const char *fasta, const char *name, size_t max_keep,
+                      char **out, dna_ingest_stats_t *stats);
+
+// Bytes per second for a stats record (0 when too fast to time)
+double dna_ingest_rate(const dna_ingest_stats_t *stats);
+
+#endif
@@ -6,41 +6,435 @@ Brief: DNA subsequence search using multiple processes with POSIX
        shared memory and a POSIX named semaphore to protect shared results.
        Each child examines interleaved starting positions (i, i+P, …).
        Output format matches the assignment exactly (3 lines).
-Compile by: gcc -Wall prog2.c -o prog1 -lpthread
+       Options (given before the positional args):
+         --early-abandon   stop scoring an alignment once it cannot beat
+                           the best count seen so far (local or global)
+         --build-index     build a k-mer seed index: <seq_file> <index_file>
+         --query           search an index with seed-and-extend:
+                           <index_file> <subseq_file> <num_procs>
+         --edit            best end position under edit distance (Myers'
+                           bit-vector algorithm, blocked past 64 bases)
+         --time            also print the search time
+         --serve           keep the sequence and workers resident and answer
+                           queries on a Unix socket (one client at a time,
+                           dropped after 10 s idle; a query that loses a
+                           worker fails and the pool is restarted):
+                           <seq_file> <socket_path> <num_procs>
+         --client          send a query to a server repeatedly and report
+                           latency: <socket_path> <subseq_file> <iterations>
+         --profile FILE    also write the match count at every position to
+                           FILE (header + uint16_t per position, mmap-able);
+                           needs the full scan, so not with --early-abandon
+         --fasta-index     write <fasta_file>.fai: <fasta_file>
+         --contig NAME     search only record NAME of a FASTA sequence file,
+                           located through its .fai
+         --iupac           keep N and other IUPAC codes (so coordinates match
+                           the file) and count a base as matching when the
+                           two codes' base sets overlap
+         --both-strands    score the pattern and its reverse complement at
+                           every position in one pass; report the strand
+         --instrument      per-worker table: positions, bases compared, wall
+                           and CPU time, time blocked in sem_wait, page
+                           faults; plus aggregate throughput and imbalance
+         --hugepages MODE  back the sequence with huge pages: 'thp'
+                           (madvise) or 'explicit' (MAP_HUGETLB, falls back
+                           to thp when none are reserved)
+         --numa-replicate  copy the sequence once per NUMA node (first
+                           touch on that node) and pin each worker to a
+                           node, reading its local copy
+         --db              search every file of a directory (or listed
+                           one path per line in a file) in chunks pulled
+                           from a shared queue; report the best hit per
+                           file and overall, and the scan rate:
+                           <directory|file_list> <subseq_file> <num_procs>
+         --backend NAME    run workers as forked processes ('process',
+                           the default), threads sharing this process
+                           ('thread'), or pick ('auto')
+         --matrix FILE     rank by a substitution-matrix score instead of
+                           the match count: 16 integers (rows: sequence
+                           base, columns: pattern base, order A C G T;
+                           letters and '#' comments are ignored), or 256
+                           with --iupac (order of the base-set masks:
+                           - A C M G R S V T W Y H K D B N). A 4x4 matrix
+                           under --iupac scores a pair of codes by their
+                           best member pair. Entries lie in -128..127.
+         --deadline MS     stop MS milliseconds after start and print the
+                           best result so far: workers scan every 1024th
+                           of their positions first, then fill in at
+                           halving steps, publishing improvements as they
+                           go; also prints the fraction of positions
+                           covered
+         --checkpoint FILE save progress (each worker's completed
+                           positions and best, or the finished --db
+                           chunks and per-file hits) to FILE every 10 s
+                           and on SIGTERM/SIGINT, written to FILE.tmp,
+                           fsync'd and renamed; FILE is removed when the
+                           scan completes
+         --checkpoint-interval MS  time between checkpoints
+         --resume          continue from the --checkpoint FILE if it
+                           exists (same inputs, options and num_procs)
+         --filter PCT      only report windows of at least PCT% identity:
+                           aligned q-grams shared with the pattern are
+                           counted per window (q-gram lemma) and only
+                           windows reaching the lemma's bound are scored;
+                           prints the fraction of windows verified. Only
+                           windows fully inside the sequence are scored;
+                           -1 means no window reaches PCT
+         --kernel NAME     Hamming kernel: 'auto' (default; picks 'packed'
+                           for plain scans of patterns up to 64 bases and
+                           'tiled' for longer ones), 'generic', 'packed'
+                           (2-bit pattern held in registers, text window
+                           slid by shifts) or 'tiled' (blocks of starts
+                           scored against one L1-sized pattern block at a
+                           time, four starts per pattern load). When a
+                           kernel is named explicitly, the L1D and LLC
+                           read misses of the search are counted with
+                           perf_event_open and printed (or 'unavailable')
+       num_procs may be 'auto': the count comes from the online CPUs and
+       the amount of work (one worker, in-process, when the work is too
+       small to pay for starting more); the choice is printed to stderr.
+       FASTA headers are skipped; with several records the best hit is
+       also reported as record:offset.
+Compile by: gcc -Wall prog2.c dna_ingest.c -o prog2 -lpthread
 Compiler: gcc
 **************************************************************************/
 
-#define _POSIX_C_SOURCE 200809L
+#define _GNU_SOURCE   // MAP_HUGETLB, MADV_HUGEPAGE, sched_setaffinity
 
+#include <dirent.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
 #include <semaphore.h>
 #include <signal.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <linux/perf_event.h>
 #include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
 #include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/time.h>
 #include <sys/types.h>
+#include <sys/un.h>
 #include <sys/wait.h>
+#include <time.h>
 #include <unistd.h>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#ifdef __x86_64__
+#include <tmmintrin.h>   // pshufb in target("ssse3") functions
+#endif
+
+#include "dna_ingest.h"
+
 // Max input sizes
 #define MAX_SEQUENCE_SIZE      1048576   // 1MB
 #define MAX_SUBSEQUENCE_SIZE     10240   // 10KB
 
+// Early-abandon tuning: bound is checked every EA_BLOCK bases and the
+// global best is re-read (and the local best published) every
+// EA_SYNC_POSITIONS positions; the EA_SEEDS best first blocks are scored
+// in full up front to seed the bound
+#define EA_BLOCK                    32
+#define EA_SYNC_POSITIONS         4096
+#define EA_SEEDS                     8
+
+// Huge page size assumed for alignment/rounding, and node limit
+#define HUGE_PAGE_SIZE   (2u * 1024 * 1024)
+#define MAX_NUMA_NODES   64
+
+// K-mer seed index: k bases per seed (4^k buckets), buckets with more
+// hits than KMER_MAX_HITS are treated as repeats and not used as seeds
+#define KMER_K                      10
+#define KMER_BUCKETS      (1u << (2 * KMER_K))
+#define KMER_MAX_HITS              256
+#define KMER_MAGIC          "DNAKMER2"
+
+// On-disk index header; bucket offsets, positions and the filtered
+// sequence follow at the given byte offsets so the file can be mmapped
+typedef struct {
+    char     magic[8];
+    uint32_t k;
+    uint32_t seq_len;
+    uint64_t offsets_off;      // uint32_t[KMER_BUCKETS + 1]
+    uint64_t positions_off;    // uint32_t[seq_len - k + 1]
+    uint64_t seq_off;          // char[seq_len]
+} kmer_index_header_t;
+
 // Structure stored in shared memory for best result
 typedef struct {
     int best_position;
     int best_count;
+    int best_strand;            // 0 forward, 1 reverse complement
+    long long compares_done;    // base compares performed (early abandon)
+    long long positions_done;   // positions scored so far (--deadline)
+    long long windows_passed;   // windows the q-gram filter sent to verify
+    int cancel;                 // set by the parent when the deadline passes
 } shared_results_t;
 
+// Per-worker measurements (--instrument), stored after shared_results_t
+// in the shared segment, one slot per worker
+typedef struct {
+    long long positions;        // alignment starts (or DP columns) scanned
+    long long bases;            // base compares performed
+    double    wall_ms;
+    double    cpu_ms;
+    double    sem_wait_ms;      // blocked in sem_wait
+    long      minor_faults;
+    long      major_faults;
+} worker_stats_t;
+
+// Server mode: shared job block holding the results and the current query
+typedef struct {
+    shared_results_t results;
+    int shutdown;              // workers exit when woken with this set
+    int failed;                // set by a worker whose search failed
+    int next_slice;            // next unclaimed slice, taken under g_sem
+    size_t pattern_len;
+    char pattern[MAX_SUBSEQUENCE_SIZE + 1];
+} server_job_t;
+
+// Server wire protocol (native byte order, local socket only): a request
+// is a header followed by 'len' raw pattern bytes, answered by one reply
+#define SERVER_MAGIC        0x51414E44u   // "DNAQ"
+#define SERVER_MAX_REQUEST  (4 * MAX_SUBSEQUENCE_SIZE)
+#define SERVER_IO_TIMEOUT_S 10            // drop a client idle this long
+#define SERVER_POLL_MS      100           // pool liveness check while waiting
+
+typedef struct {
+    uint32_t magic;
+    uint32_t len;
+} query_header_t;
+
+typedef struct {
+    int32_t status;            // 0 ok, 1 bad query, 2 search failed
+    int32_t best_position;
+    int32_t best_count;
+} query_reply_t;
+
+// Profile output file: header followed by one uint16_t count per
+// alignment start, written in place through a shared file mapping
+#define PROFILE_MAGIC   "DNAPROF1"
+#define PROFILE_VERSION 1
+
+typedef struct {
+    char     magic[8];
+    uint32_t version;
+    uint32_t header_size;      // counts start at this byte offset
+    uint64_t seq_len;
+    uint64_t subseq_len;
+    uint64_t count;            // number of uint16_t entries (= seq_len)
+} profile_header_t;
+
+// Command-line options
+typedef struct {
+    int early_abandon;
+    int build_index;
+    int query;
+    int edit;
+    int time;
+    int serve;
+    int client;
+    const char *profile_file;
+    int fasta_index;
+    const char *contig;
+    int iupac;
+    int both_strands;
+    int instrument;
+    const char *hugepages;      // NULL, "thp" or "explicit"
+    int numa_replicate;
+    const char *kernel;         // NULL/"auto", "generic" or "packed"
+    int db;
+    int auto_procs;             // num_procs given as "auto"
+    const char *backend;        // NULL/"auto", "process" or "thread"
+    const char *matrix_file;
+    double deadline_ms;         // 0: run to completion
+    const char *checkpoint_file;
+    double checkpoint_ms;       // interval between checkpoint writes
+    int resume;
+    double filter_pct;          // q-gram filter: minimum identity, 0 = off
+} options_t;
+
+// Database search (--db): every file of a directory or list is split at
+// line starts into chunks of about DB_CHUNK_BYTES, and workers take the
+// chunks from a queue in shared memory
+#define DB_CHUNK_BYTES   (8u * 1024 * 1024)
+#define DB_SPLIT_WINDOW  65536   // bytes searched for a line start past a split
+#define DB_EXTEND_BYTES  4096    // raw bytes filtered at a time past a chunk end
+
+typedef struct {
+    int next_task;           // queue head, advanced under the lock
+    int task_count;
+    int file_count;
+} db_queue_t;
+
+typedef struct {
+    int       file;          // index into db_paths
+    int       last;          // final chunk of its file (pattern may overhang)
+    long long start, end;    // raw byte range [start, end)
+    long long bases;         // bases in the range (set by its worker)
+    int       done;          // scored and merged (checkpointed)
+} db_task_t;
+
+typedef struct {
+    int       best_count;    // -1 until a chunk of the file reports
+    int       best_task;
+    long long best_offset;   // base offset within best_task
+} db_file_hit_t;
+
 // Global variables for sequence data
 static char *seq        = NULL;
 static char *subseq     = NULL;
 static size_t seq_len   = 0;
 static size_t subseq_len = 0;
 static int num_procs    = 0;
+static char *subseq_rc  = NULL;   // reverse complement (--both-strands)
+static options_t opts;
+static dna_ingest_stats_t seq_ingest;
+static dna_record_list_t seq_records;
+
+// Substitution scoring (--matrix): 4x4 table indexed code(seq)*4 +
+// code(pat) with dna_code order A C T G, stored biased so every entry is
+// a non-negative byte (SAD sums them); the IUPAC form is a 256-entry
+// table indexed mask(seq)*16 + mask(pat)
+static int8_t score_table[16];
+static uint8_t score_biased[16];
+static int score_bias = 0;
+static int16_t iupac_score_table[256];
+static char *subseq_code = NULL;     // pattern codes (0-3) for the shuffle index
+
+// Deadline mode: workers visit their positions every DEADLINE_COARSE-th
+// first and halve the step each pass, checking the cancel flag (and
+// publishing any improvement) after scoring about DEADLINE_CHECK_BASES
+// pattern bases, so a long pattern cannot stretch the stop. The parent
+// only raises the flag; it never kills a worker, which could die inside
+// publish_best with the result half written.
+#define DEADLINE_COARSE       1024
+#define DEADLINE_CHECK_BASES  (256 * 1024)
+#define DEADLINE_POLL_US       200
+static pid_t *child_pids = NULL;
+static double t_program = 0.0;
+
+// Checkpoints (--checkpoint FILE): each plain-scan worker keeps a slot
+// after the results (and stats) in shm with the next of its interleaved
+// positions and its best so far; database workers mark chunks done. The
+// parent snapshots these every checkpoint_ms into FILE.tmp, fsyncs it and
+// renames it over FILE, and also on SIGTERM/SIGINT before stopping.
+#define CKPT_MAGIC          "DNACKPT1"
+#define CKPT_INTERVAL_MS    10000.0
+#define CKPT_BLOCK          4096      // positions between slot updates
+enum { CKPT_SCAN = 1, CKPT_DB = 2 };
+
+typedef struct {
+    char     magic[8];
+    uint32_t mode;          // CKPT_SCAN or CKPT_DB
+    int32_t  workers;       // scan: worker count (fixes the interleave)
+    uint64_t fingerprint;   // inputs and scoring the run depends on
+    uint64_t entries;       // scan: worker slots; db: chunks
+    uint64_t files;         // db: per-file hits after the chunks
+} ckpt_header_t;
+
+// Best packed as count (high 32 bits) and position so a snapshot never
+// pairs one worker's count with another moment's position
+typedef struct {
+    long long next_k;       // positions w + k*P for k < next_k are done
+    long long best;
+} ckpt_slot_t;
+
+typedef struct {
+    long long bases;
+    int       done;
+} ckpt_task_t;
+
+// q-gram filter (--filter PCT): a full window with at most e mismatches
+// shares at least (m - q + 1) - q*e aligned q-grams with the pattern, so
+// windows below that count cannot reach PCT identity. The pattern's
+// q-grams (2-bit codes) are hashed to their offsets; each text q-gram at
+// t adds one to window t - offset for every offset it occurs at.
+#define QGRAM_MAX_Q   15
+static int qg_q = 0;
+static int qg_threshold = 0;
+static int qg_need = 0;                // matches a window needs (m - e)
+static uint32_t qg_mask_bits = 0;      // hash table size - 1
+static uint32_t *qg_keys = NULL;       // q-gram code per slot
+static uint32_t *qg_start = NULL;      // first offset in qg_offsets
+static uint32_t *qg_count = NULL;      // 0 marks an empty slot
+static uint32_t *qg_offsets = NULL;    // pattern offsets grouped by q-gram
+
+static ckpt_slot_t *ckpt_slots = NULL;
+static sigset_t ckpt_saved_mask;
+static int ckpt_writes = 0;
+static double ckpt_write_ms = 0.0;
+static int ckpt_resumed = 0;
+static uint64_t ckpt_fp = 0;         // ckpt_fingerprint(), taken once
+
+// Instrumented worker: its stats slot, and the work done by the
+// early-abandon search (which cannot be derived from the layout).
+// Thread-local so the thread backend keeps one set per worker.
+static __thread worker_stats_t *my_stats = NULL;
+static __thread long long ea_positions = 0;
+static __thread long long ea_compares = 0;
+
+// Worker backends: forked processes (default), threads sharing the
+// parent's memory, or the parent alone for work too small to split
+typedef enum { BACKEND_PROCESS, BACKEND_THREAD, BACKEND_INLINE } backend_t;
+static backend_t backend = BACKEND_PROCESS;
+
+// Auto sizing: base compares a worker should own to amortize its start
+// (thread start is tens of microseconds, ~1 ms of scanning covers it),
+// and per-worker work above which forking (isolation, per-process
+// accounting) costs under ~1% and processes are kept
+#define AUTO_WORK_PER_WORKER   (4LL * 1000 * 1000)
+#define AUTO_PROCESS_WORK      (256LL * 1000 * 1000)
+
+// Sequence copies placed by place_sequence(): huge-page backed and/or
+// one per NUMA node, with the CPUs each node's workers are pinned to
+static char *seq_copies[MAX_NUMA_NODES];
+static size_t seq_copy_len = 0;
+static int seq_copy_count = 0;
+static char *packed_copies[MAX_NUMA_NODES];   // seq_packed, placed the same way
+static size_t packed_copy_len = 0;
+static int packed_copy_count = 0;
+static cpu_set_t numa_cpus[MAX_NUMA_NODES];
+static int numa_nodes = 0;
+static const char *seq_page_kind = "4k";
+
+// Packed short-pattern kernels: 2-bit text (with padding words) and the
+// pattern as up to two register words plus their valid-base masks
+#define PACKED_MAX_PATTERN   64
+#define ODD_BITS             0x5555555555555555ull
+static uint64_t *seq_packed = NULL;
+static uint64_t pat_words[2];
+static uint64_t pat_masks[2];
+static int use_packed = 0;
+
+// Tiled kernel: TILE_POSITIONS consecutive starts are scored against one
+// TILE_PATTERN-base block of the pattern before the next block, GEMM
+// style, so the block and the text it meets stay in L1 across the tile;
+// four starts share each pattern load. TILE_PATTERN / 16 must stay under
+// 256 so the byte counters cannot wrap within a block.
+#define TILE_POSITIONS   256
+#define TILE_PATTERN    2048
+static int use_tiled = 0;
+
+// Query mode: the mapped index (seq points into it) and the candidate
+// alignment starts found by seeding
+static void *index_map = NULL;
+static size_t index_map_len = 0;
+static uint32_t *candidates = NULL;
+static size_t n_candidates = 0;
+
+// Edit mode: Myers match vectors, one 64-bit word per block per base
+static uint64_t *edit_peq = NULL;
+static size_t edit_blocks = 0;
 
 // Shared memory and semaphore names
 static char shm_name[64];
@@ -48,46 +442,377 @@ static char sem_name[64];
 
 // Handles for shared objects
 static shared_results_t *g_results = NULL;
+static size_t shm_len = sizeof(shared_results_t);
 static int shm_fd = -1;
 static sem_t *g_sem = NULL;
 
+// Server mode: job block plus start/done semaphores for the worker pool
+static server_job_t *g_job = NULL;
+static char start_sem_name[64];
+static char done_sem_name[64];
+static sem_t *g_start_sem = NULL;
+static sem_t *g_done_sem = NULL;
+static volatile sig_atomic_t stop_requested = 0;
+
+// Profile mode: shared file mapping the workers write counts into
+static void *profile_map = NULL;
+static size_t profile_map_len = 0;
+static uint16_t *profile_counts = NULL;
+
+// Database mode: file list (parent memory, inherited by the workers) and
+// the queue, chunk table and per-file hits in shared memory
+static char **db_paths = NULL;
+static long long *db_sizes = NULL;
+static int db_file_count = 0;
+static db_queue_t *g_db = NULL;
+static db_task_t *db_tasks = NULL;
+static db_file_hit_t *db_hits = NULL;
+
 // Function prototypes
-static ssize_t read_and_filter_acgt(const char *fname, char **out, size_t max_keep);
+static int parse_options(int argc, char *argv[], char **pos_args);
+static int search_worker(int worker_id, shared_results_t *res, sem_t *lock);
+static int search_worker_bounded(int worker_id, shared_results_t *res, sem_t *lock);
+static int publish_best(shared_results_t *res, sem_t *lock, int best_pos, int best_cnt);
+static int publish_best_strand(shared_results_t *res, sem_t *lock, int best_pos, int best_cnt,
+                               int strand);
+static int search_worker_both(int worker_id, shared_results_t *res, sem_t *lock);
+static int run_worker_instrumented(int worker_id, shared_results_t *res, sem_t *lock);
+static void print_worker_stats(const shared_results_t *res, double wall_ms);
+static int place_sequence(void);
+static int place_copies(const void *src, size_t bytes, int copies, char **out, size_t *len_out);
+static int setup_packed_kernel(void);
+static int search_worker_packed(int worker_id, shared_results_t *res, sem_t *lock);
+static void worker_slice(int worker_id, size_t *lo, size_t *hi);
+static void packed_best(size_t lo, size_t hi, int *best_pos, int *best_cnt);
+static int search_worker_tiled(int worker_id, shared_results_t *res, sem_t *lock);
+static void tiled_best(size_t lo, size_t hi, int *best_pos, int *best_cnt);
+static int open_cache_counter(int cache);
+static void print_cache_misses(int l1_fd, int llc_fd);
+static int search_database(const char *db_path, const char *subseq_file);
+static int choose_backend(void);
+static int run_threads(void);
+static void bind_worker_node(int worker_id);
+static long long full_compare_count(void);
+static int count_matches(size_t pos);
+static size_t count_span(const char *s, const char *p, size_t n);
+static int count_matches_iupac(size_t pos);
+static int search_candidates(int worker_id, shared_results_t *res, sem_t *lock);
+static int build_index(const char *seq_file, const char *index_file);
+static int load_index(const char *index_file);
+static int find_candidates(void);
+static int build_edit_peq(void);
+static int search_edit(int worker_id, shared_results_t *res, sem_t *lock);
+static double now_ms(void);
+static int run_worker(int worker_id, shared_results_t *res, sem_t *lock);
+static int search_worker_profile(int worker_id, shared_results_t *res, sem_t *lock);
+static int search_worker_iupac(int worker_id, shared_results_t *res, sem_t *lock);
+static int load_matrix(const char *fname);
+static int search_worker_matrix(int worker_id, shared_results_t *res, sem_t *lock);
+static int search_worker_deadline(int worker_id, shared_results_t *res, sem_t *lock);
+static int wait_with_deadline(int started, int *timed_out);
+static int search_worker_checkpointed(int worker_id, shared_results_t *res, sem_t *lock);
+static uint64_t ckpt_fingerprint(void);
+static int load_checkpoint(void);
+static int wait_with_checkpoints(int started, int *interrupted);
+static void block_child_signals(void);
+static int build_qgram_filter(void);
+static int search_worker_qgram(int worker_id, shared_results_t *res, sem_t *lock);
+static int read_full(int fd, void *buf, size_t n);
+static int write_full(int fd, const void *buf, size_t n);
+static int open_profile(const char *fname);
+static int close_profile(void);
+static int serve(const char *seq_file, const char *sock_path);
+static int client(const char *sock_path, const char *subseq_file, int iterations);
 static void cleanup_parent(void);
 static void cleanup_child(void);
 static void usage(const char *prog);
 
 // Main
 int main(int argc, char *argv[]) {
-    // Check input arguments
-    if (argc != 4) {
+    // Split options from positional arguments
+    t_program = now_ms();
+    char *args[3];
+    int npos = parse_options(argc, argv, args);
+    if (opts.build_index) {
+        if (npos != 2) {
+            fprintf(stderr, "wrong number of args\n");
+            usage(argv[0]);
+            return 1;
+        }
+        return build_index(args[0], args[1]);
+    }
+    if (opts.fasta_index) {
+        if (npos != 1) {
+            fprintf(stderr, "wrong number of args\n");
+            usage(argv[0]);
+            return 1;
+        }
+        char fai_path[4096];
+        snprintf(fai_path, sizeof(fai_path), "%s.fai", args[0]);
+        if (dna_fai_build(args[0], fai_path) != 0) return 1;
+        printf("Index Written:       %s\n", fai_path);
+        return 0;
+    }
+    if (npos != 3) {
         fprintf(stderr, "wrong number of args\n");
         usage(argv[0]);
         return 1;
     }
 
-    // Parse number of processes
-    num_procs = atoi(argv[3]);
+    // Client mode: third argument is the iteration count
+    if (opts.client) {
+        int iterations = atoi(args[2]);
+        if (iterations <= 0) {
+            fprintf(stderr, "need positive number of iterations\n");
+            return 1;
+        }
+        return client(args[0], args[1], iterations);
+    }
+
+    // Both-strand scoring is a variant of the plain scan
+    if (opts.both_strands && (opts.early_abandon || opts.edit || opts.query || opts.serve ||
+                              opts.profile_file || opts.iupac)) {
+        fprintf(stderr, "--both-strands supports the plain scan only\n");
+        return 1;
+    }
+
+    // Weighted scores replace the match count of the plain scan
+    if (opts.matrix_file && (opts.early_abandon || opts.edit || opts.query || opts.serve ||
+                             opts.profile_file || opts.both_strands || opts.db)) {
+        fprintf(stderr, "--matrix supports the plain scan (with or without --iupac) only\n");
+        return 1;
+    }
+
+    // The deadline scan reorders the plain, IUPAC and matrix scans
+    if (opts.deadline_ms > 0.0 && (opts.early_abandon || opts.edit || opts.query || opts.serve ||
+                                   opts.profile_file || opts.both_strands || opts.db)) {
+        fprintf(stderr, "--deadline supports the plain, --iupac and --matrix scans only\n");
+        return 1;
+    }
+
+    // The q-gram filter sits in front of the plain Hamming scan
+    if (opts.filter_pct > 0.0 && (opts.early_abandon || opts.edit || opts.query || opts.serve ||
+                                  opts.profile_file || opts.both_strands || opts.iupac ||
+                                  opts.matrix_file || opts.deadline_ms > 0.0 ||
+                                  opts.checkpoint_file || opts.db)) {
+        fprintf(stderr, "--filter supports the plain Hamming scan only\n");
+        return 1;
+    }
+
+    // Checkpoints cover the plain, IUPAC and matrix scans and --db
+    if (opts.checkpoint_file && (opts.early_abandon || opts.edit || opts.query || opts.serve ||
+                                 opts.profile_file || opts.both_strands || opts.deadline_ms > 0.0)) {
+        fprintf(stderr, "--checkpoint supports the plain, --iupac, --matrix and --db scans only\n");
+        return 1;
+    }
+    if (opts.resume && !opts.checkpoint_file) {
+        fprintf(stderr, "--resume needs --checkpoint FILE\n");
+        return 1;
+    }
+
+    // IUPAC masks only go through the plain and profile scans
+    if (opts.iupac && (opts.early_abandon || opts.edit || opts.query || opts.serve)) {
+        fprintf(stderr, "--iupac supports the plain and --profile scans only\n");
+        return 1;
+    }
+
+    // --contig fetches one record's A/C/G/T bases; the IUPAC reader and the
+    // k-mer index would scan the whole file under the record's name
+    if (opts.contig && (opts.iupac || opts.query)) {
+        fprintf(stderr, "--contig cannot be combined with --iupac or --query\n");
+        return 1;
+    }
+
+    // Parse number of processes ("auto" sizes it from the CPUs and work)
+    opts.auto_procs = strcmp(args[2], "auto") == 0;
+    num_procs = opts.auto_procs ? 1 : atoi(args[2]);
     if (num_procs <= 0) {
         fprintf(stderr, "need positive number of processes\n");
         return 1;
     }
 
-    // Read sequence file (keep only A/C/G/T)
-    ssize_t n_seq = read_and_filter_acgt(argv[1], &seq, MAX_SEQUENCE_SIZE);
-    if (n_seq < 0) return 1;
-    seq_len = (size_t)n_seq;
+    // Resident and database workers run long: one process per CPU
+    if ((opts.serve || opts.db) && opts.auto_procs) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        num_procs = online > 0 ? (int)online : 1;
+        fprintf(stderr, "auto: %d process(es) (%s mode runs one per online CPU)\n",
+                num_procs, opts.serve ? "server" : "database");
+    }
+    if ((opts.serve || opts.db) && opts.backend && strcmp(opts.backend, "thread") == 0) {
+        fprintf(stderr, "--backend thread is not supported with --serve or --db\n");
+        return 1;
+    }
+
+    // Database mode: first argument is a directory or a file list
+    if (opts.db) {
+        if (opts.edit || opts.query || opts.serve || opts.profile_file || opts.contig ||
+            opts.iupac || opts.both_strands || opts.early_abandon || opts.instrument ||
+            opts.hugepages || opts.numa_replicate) {
+            fprintf(stderr, "--db supports the plain Hamming scan only\n");
+            return 1;
+        }
+        return search_database(args[0], args[1]);
+    }
+
+    // Server mode: second argument is the socket path
+    if (opts.serve) {
+        if (opts.edit || opts.query || opts.profile_file) {
+            fprintf(stderr, "--serve supports the Hamming search only\n");
+            return 1;
+        }
+        // The server loads the whole file with the plain reader and runs
+        // the generic scan without instrumentation for every query
+        if (opts.contig || opts.hugepages || opts.numa_replicate || opts.instrument ||
+            opts.kernel) {
+            fprintf(stderr, "--serve cannot be combined with --contig, --hugepages, "
+                            "--numa-replicate, --instrument or --kernel\n");
+            return 1;
+        }
+        return serve(args[0], args[1]);
+    }
+
+    // Read sequence file (keep only A/C/G/T), map it from the index, or
+    // fetch one FASTA record through its .fai
+    if (opts.query) {
+        if (load_index(args[0]) != 0) { cleanup_parent(); return 1; }
+    } else if (opts.iupac) {
+        ssize_t n_seq = dna_ingest_iupac(args[0], MAX_SEQUENCE_SIZE, &seq, &seq_ingest,
+                                         &seq_records);
+        if (n_seq < 0) return 1;
+        seq_len = (size_t)n_seq;
+    } else if (opts.contig) {
+        ssize_t n_seq = dna_fai_fetch(args[0], opts.contig, MAX_SEQUENCE_SIZE, &seq, &seq_ingest);
+        if (n_seq < 0) return 1;
+        seq_len = (size_t)n_seq;
+    } else {
+        ssize_t n_seq = dna_ingest_fasta(args[0], MAX_SEQUENCE_SIZE, &seq, &seq_ingest,
+                                         &seq_records);
+        if (n_seq < 0) return 1;
+        seq_len = (size_t)n_seq;
+    }
 
     // Read subsequence file (keep only A/C/G/T)
-    ssize_t n_sub = read_and_filter_acgt(argv[2], &subseq, MAX_SUBSEQUENCE_SIZE);
-    if (n_sub < 0) { free(seq); return 1; }
+    ssize_t n_sub = opts.iupac
+        ? dna_ingest_iupac(args[1], MAX_SUBSEQUENCE_SIZE, &subseq, NULL, NULL)
+        : dna_ingest_file(args[1], MAX_SUBSEQUENCE_SIZE, &subseq, NULL);
+    if (n_sub < 0) { cleanup_parent(); return 1; }
     subseq_len = (size_t)n_sub;
 
     // Check for empty files
     if (subseq_len == 0 || seq_len == 0) {
         fprintf(stderr, "empty sequence or subsequence\n");
-        free(seq);
-        free(subseq);
+        cleanup_parent();
+        return 1;
+    }
+
+    // Move the sequence onto huge pages and/or per-node replicas
+    if (opts.hugepages || opts.numa_replicate) {
+        if (opts.query || opts.contig) {
+            fprintf(stderr, "--hugepages/--numa-replicate need a plain sequence file\n");
+            cleanup_parent();
+            return 1;
+        }
+        if (place_sequence() != 0) {
+            cleanup_parent();
+            return 1;
+        }
+    }
+
+    // Pick the Hamming kernel: packed registers for short plain scans. The
+    // packed kernel scores a short pattern faster than early abandon could
+    // skip any of it, so such --early-abandon scans run as plain ones.
+    int plain_scan = !(opts.edit || opts.query || opts.profile_file || opts.iupac ||
+                       opts.both_strands || opts.matrix_file || opts.deadline_ms > 0.0 ||
+                       opts.checkpoint_file || opts.filter_pct > 0.0 ||
+                       (opts.early_abandon && subseq_len > PACKED_MAX_PATTERN));
+    int want_packed = opts.kernel && strcmp(opts.kernel, "packed") == 0;
+    int want_generic = opts.kernel && strcmp(opts.kernel, "generic") == 0;
+    int want_tiled = opts.kernel && strcmp(opts.kernel, "tiled") == 0;
+    if (want_packed && (!plain_scan || subseq_len > PACKED_MAX_PATTERN)) {
+        fprintf(stderr, "--kernel packed needs a plain scan of at most %d bases\n",
+                PACKED_MAX_PATTERN);
+        cleanup_parent();
+        return 1;
+    }
+    if (want_tiled && !plain_scan) {
+        fprintf(stderr, "--kernel tiled needs a plain scan\n");
+        cleanup_parent();
+        return 1;
+    }
+    use_tiled = want_tiled || (!want_generic && !want_packed && plain_scan &&
+                               subseq_len > PACKED_MAX_PATTERN);
+    if (!want_generic && !want_tiled && plain_scan && subseq_len <= PACKED_MAX_PATTERN) {
+        if (setup_packed_kernel() != 0) {
+            cleanup_parent();
+            return 1;
+        }
+    }
+
+    // Substitution matrix and the pattern's shuffle-index codes
+    if (opts.matrix_file) {
+        if (load_matrix(opts.matrix_file) != 0) {
+            cleanup_parent();
+            return 1;
+        }
+        subseq_code = (char *)malloc(subseq_len);
+        if (!subseq_code) {
+            perror("malloc failed");
+            cleanup_parent();
+            return 1;
+        }
+        for (size_t j = 0; j < subseq_len; j++)
+            subseq_code[j] = (char)dna_code(subseq[j]);
+    }
+
+    // Pattern q-gram table for the filter
+    if (opts.filter_pct > 0.0 && build_qgram_filter() != 0) {
+        cleanup_parent();
+        return 1;
+    }
+
+    // Seed the query against the index to get candidate starts
+    if (opts.query && find_candidates() != 0) {
+        cleanup_parent();
+        return 1;
+    }
+
+    // Reverse complement of the pattern for the fused two-strand scan
+    if (opts.both_strands) {
+        subseq_rc = (char *)malloc(subseq_len + 1);
+        if (!subseq_rc) {
+            perror("malloc failed");
+            cleanup_parent();
+            return 1;
+        }
+        for (size_t j = 0; j < subseq_len; j++) {
+            char c = subseq[subseq_len - 1 - j];
+            subseq_rc[j] = c == 'A' ? 'T' : c == 'C' ? 'G' : c == 'G' ? 'C' : 'A';
+        }
+        subseq_rc[subseq_len] = '\0';
+    }
+
+    // Precompute match vectors for the edit-distance search
+    if (opts.edit && build_edit_peq() != 0) {
+        cleanup_parent();
+        return 1;
+    }
+
+    // Map the profile output; children inherit the shared mapping
+    if (opts.profile_file) {
+        if (opts.edit || opts.query || opts.early_abandon) {
+            fprintf(stderr, "--profile needs the full Hamming scan\n");
+            cleanup_parent();
+            return 1;
+        }
+        if (open_profile(opts.profile_file) != 0) {
+            cleanup_parent();
+            return 1;
+        }
+    }
+
+    // Worker count and backend
+    if (choose_backend() != 0) {
+        cleanup_parent();
         return 1;
     }
 
@@ -100,20 +825,26 @@ int main(int argc, char *argv[]) {
     shm_fd = shm_open(shm_name, O_CREAT | O_EXCL | O_RDWR, 0666);
     if (shm_fd == -1) {
         perror("shm_open failed");
-        free(seq);
-        free(subseq);
+        shm_name[0] = '\0';
+        cleanup_parent();
         return 1;
     }
 
-    // Resize shared memory to struct size
-    if (ftruncate(shm_fd, (off_t)sizeof(shared_results_t)) == -1) {
+    // Resize shared memory to struct size (plus stats slots if asked)
+    shm_len = sizeof(shared_results_t);
+    if (opts.instrument)
+        shm_len += (size_t)num_procs * sizeof(worker_stats_t);
+    size_t slots_off = shm_len;
+    if (opts.checkpoint_file)
+        shm_len += (size_t)num_procs * sizeof(ckpt_slot_t);
+    if (ftruncate(shm_fd, (off_t)shm_len) == -1) {
         perror("ftruncate failed");
         cleanup_parent();
         return 1;
     }
 
-    // Map shared memory
-    g_results = (shared_results_t *)mmap(NULL, sizeof(shared_results_t),
+    // Map shared memory (new pages read as zero, so stats start cleared)
+    g_results = (shared_results_t *)mmap(NULL, shm_len,
                                          PROT_READ | PROT_WRITE, MAP_SHARED,
                                          shm_fd, 0);
     if (g_results == MAP_FAILED) {
@@ -124,7 +855,26 @@ int main(int argc, char *argv[]) {
 
     // Initialize shared results
     g_results->best_position = -1;
-    g_results->best_count    = -1;
+    g_results->best_count    = opts.edit || opts.matrix_file ? INT_MIN : -1;
+    g_results->best_strand   = 0;
+    g_results->compares_done = 0;
+    g_results->positions_done = 0;
+    g_results->cancel        = 0;
+    g_results->windows_passed = 0;
+
+    // Worker progress slots, fresh or from the checkpoint
+    if (opts.checkpoint_file) {
+        ckpt_slots = (ckpt_slot_t *)((char *)g_results + slots_off);
+        for (int i = 0; i < num_procs; i++) {
+            ckpt_slots[i].next_k = 0;
+            ckpt_slots[i].best = (long long)((uint64_t)(uint32_t)INT_MIN << 32 | 0xFFFFFFFFu);
+        }
+        ckpt_fp = ckpt_fingerprint();
+        if (opts.resume && load_checkpoint() != 0) {
+            cleanup_parent();
+            return 1;
+        }
+    }
 
     // Create semaphore for synchronization
     g_sem = sem_open(sem_name, O_CREAT | O_EXCL, 0666, 1);
@@ -134,16 +884,42 @@ int main(int argc, char *argv[]) {
         return 1;
     }
 
+    // Deadline and checkpoint modes reap their children by pid, and
+    // checkpoint mode kills them by pid when interrupted
+    if (opts.deadline_ms > 0.0 || opts.checkpoint_file) {
+        child_pids = (pid_t *)calloc((size_t)num_procs, sizeof(pid_t));
+        if (!child_pids) {
+            perror("calloc failed");
+            cleanup_parent();
+            return 1;
+        }
+    }
+
     // Track number of successful forks
+    if (opts.checkpoint_file) block_child_signals();
     int started = 0;
+    // Opened before the workers start so their misses are inherited
+    int l1_fd = -1, llc_fd = -1;
+    if (opts.kernel) {
+        l1_fd = open_cache_counter(PERF_COUNT_HW_CACHE_L1D);
+        llc_fd = open_cache_counter(PERF_COUNT_HW_CACHE_LL);
+    }
+    double t_start = now_ms();
+
+    // Threads and the inline worker share this address space
+    if (backend != BACKEND_PROCESS && run_threads() != 0) {
+        cleanup_parent();
+        return 1;
+    }
 
     // Create child processes
-    for (int i = 0; i < num_procs; i++) {
+    for (int i = 0; i < num_procs && backend == BACKEND_PROCESS; i++) {
         pid_t pid = fork();
 
         // Child process
         if (pid == 0) {
             cleanup_child();
+            if (opts.checkpoint_file) sigprocmask(SIG_SETMASK, &ckpt_saved_mask, NULL);
 
             // Open shared memory in child
             int local_fd = shm_open(shm_name, O_RDWR, 0);
@@ -153,7 +929,7 @@ int main(int argc, char *argv[]) {
             }
 
             // Map shared memory
-            shared_results_t *res = (shared_results_t *)mmap(NULL, sizeof(shared_results_t),
+            shared_results_t *res = (shared_results_t *)mmap(NULL, shm_len,
                                                              PROT_READ | PROT_WRITE, MAP_SHARED,
                                                              local_fd, 0);
             if (res == MAP_FAILED) {
@@ -166,65 +942,27 @@ int main(int argc, char *argv[]) {
             sem_t *lock = sem_open(sem_name, 0);
             if (lock == SEM_FAILED) {
                 perror("child sem_open failed");
-                munmap(res, sizeof(*res));
+                munmap(res, shm_len);
                 close(local_fd);
                 _exit(1);
             }
 
-            // Each child searches interleaved starting positions
-            int worker_id = i;
-            int best_pos = -1;
-            int best_cnt = -1;
-
-            // Iterate through positions assigned to this process
-            for (size_t pos = (size_t)worker_id; pos < seq_len; pos += (size_t)num_procs) {
-                int matches = 0;
-
-                // Count matching characters between seq and subseq
-                for (size_t j = 0; j < subseq_len; j++) {
-                    size_t sidx = pos + j;
-                    if (sidx < seq_len && seq[sidx] == subseq[j]) {
-                        matches++;
-                    } else if (sidx >= seq_len) {
-                        break;
-                    }
-                }
-
-                // Track best local match
-                if (matches > best_cnt) {
-                    best_cnt = matches;
-                    best_pos = (int)pos;
-                }
-            }
+            // Pin to a node and read that node's copy of the sequence
+            if (seq_copy_count > 0) bind_worker_node(i);
 
-            // Lock semaphore before updating shared memory
-            int rc = 0;
-            if (best_cnt >= 0) {
-                if (sem_wait(lock) == -1) {
-                    perror("sem_wait failed");
-                    rc = 1;
-                } else {
-                    // Update global best result if this one is better
-                    if (best_cnt > res->best_count ||
-                        (best_cnt == res->best_count && best_pos < res->best_position)) {
-                        res->best_count    = best_cnt;
-                        res->best_position = best_pos;
-                    }
-                    if (sem_post(lock) == -1) {
-                        perror("sem_post failed");
-                        rc = 1;
-                    }
-                }
-            }
+            // Each child searches interleaved starting positions
+            int rc = opts.instrument ? run_worker_instrumented(i, res, lock)
+                                     : run_worker(i, res, lock);
 
             // Clean up child handles
             sem_close(lock);
-            munmap(res, sizeof(*res));
+            munmap(res, shm_len);
             close(local_fd);
             _exit(rc);
 
         // Parent process
         } else if (pid > 0) {
+            if (child_pids) child_pids[started] = pid;
             started++;
         } else {
             // Fork failed
@@ -237,8 +975,26 @@ int main(int argc, char *argv[]) {
         }
     }
 
+    // Deadline mode: poll, cancel at the deadline, then collect
+    int timed_out = 0;
+    if (opts.deadline_ms > 0.0 && wait_with_deadline(started, &timed_out) != 0) {
+        cleanup_parent();
+        return 1;
+    }
+
+    // Checkpoint mode: snapshot while waiting; stop on SIGTERM/SIGINT
+    if (opts.checkpoint_file) {
+        int interrupted = 0;
+        if (wait_with_checkpoints(started, &interrupted) != 0 || interrupted) {
+            if (interrupted)
+                fprintf(stderr, "interrupted; progress saved to %s\n", opts.checkpoint_file);
+            cleanup_parent();
+            return 1;
+        }
+    }
+
     // Wait for all child processes to finish
-    for (int i = 0; i < started; i++) {
+    for (int i = 0; i < started && !child_pids; i++) {
         int wstatus = 0;
         if (wait(&wstatus) == -1) {
             perror("wait failed");
@@ -252,103 +1008,2959 @@ int main(int argc, char *argv[]) {
         }
     }
 
-    // Required output format
+    double t_search = now_ms() - t_start;
+
+    // Required output format (edit mode stores -distance as the count)
     printf("Number of Processes: %d\n", num_procs);
-    printf("Best Match Position: %d\n", g_results->best_position);
-    printf("Best Match Count:    %d\n", g_results->best_count);
+    if (opts.edit) {
+        printf("Best Match End:      %d\n", g_results->best_position);
+        printf("Best Edit Distance:  %d\n", -g_results->best_count);
+    } else if (opts.matrix_file) {
+        printf("Best Match Position: %d\n", g_results->best_position);
+        printf("Best Match Score:    %d\n", g_results->best_count);
+    } else {
+        printf("Best Match Position: %d\n", g_results->best_position);
+        printf("Best Match Count:    %d\n", g_results->best_count);
+    }
+    if (opts.early_abandon) {
+        long long full = full_compare_count();
+        long long done = use_packed || use_tiled ? full : g_results->compares_done;
+        double avoided = full > 0 ? 100.0 * (double)(full - done) / (double)full : 0.0;
+        printf("Compares Avoided:    %.2f%%\n", avoided);
+    }
+    if (opts.both_strands)
+        printf("Best Match Strand:   %c\n", g_results->best_strand ? '-' : '+');
+    if (opts.contig && g_results->best_position >= 0)
+        printf("Best Match Record:   %s:%d\n", opts.contig, g_results->best_position);
+    if (seq_records.count > 1 && g_results->best_position >= 0) {
+        const dna_record_t *rec = dna_record_at(&seq_records, (size_t)g_results->best_position);
+        if (rec)
+            printf("Best Match Record:   %s:%zu\n", rec->name,
+                   (size_t)g_results->best_position - rec->start);
+    }
+    if (opts.query)
+        printf("Candidates Verified: %zu\n", n_candidates);
+    if (opts.checkpoint_file) {
+        printf("Checkpoints Written: %d (%.3f ms, %.3f%% of search time)%s\n", ckpt_writes,
+               ckpt_write_ms, t_search > 0.0 ? 100.0 * ckpt_write_ms / t_search : 0.0,
+               ckpt_resumed ? ", resumed" : "");
+        unlink(opts.checkpoint_file);
+    }
+    if (opts.kernel) print_cache_misses(l1_fd, llc_fd);
+    if (opts.filter_pct > 0.0) {
+        size_t windows = seq_len >= subseq_len ? seq_len - subseq_len + 1 : 0;
+        printf("Filter Selectivity:  %.4f%% of windows verified (%lld of %zu; q=%d, "
+               "threshold %d)\n",
+               windows ? 100.0 * (double)g_results->windows_passed / (double)windows : 0.0,
+               g_results->windows_passed, windows, qg_q, qg_threshold);
+    }
+    if (opts.deadline_ms > 0.0)
+        printf("Coverage:            %.2f%% of positions (%s)\n",
+               seq_len > 0 ? 100.0 * (double)g_results->positions_done / (double)seq_len : 0.0,
+               timed_out ? "deadline reached" : "complete");
+    if (opts.time) {
+        printf("Search Time:         %.3f ms\n", t_search);
+        if (seq_ingest.bytes_in > 0)
+            printf("Ingest Rate:         %.1f MB/s\n", dna_ingest_rate(&seq_ingest) / 1e6);
+    }
+    if (opts.hugepages || opts.numa_replicate)
+        printf("Sequence Placement:  %s pages, %d replica(s)\n", seq_page_kind, seq_copy_count);
+    if (opts.instrument)
+        print_worker_stats(g_results, t_search);
+    if (opts.profile_file) {
+        if (close_profile() != 0) {
+            cleanup_parent();
+            return 1;
+        }
+        printf("Profile Written:     %s\n", opts.profile_file);
+    }
 
     // Cleanup
     cleanup_parent();
     return 0;
 }
 
-// Reads input file and filters out invalid characters (only A/C/G/T allowed)
-static ssize_t read_and_filter_acgt(const char *fname, char **out, size_t max_keep) {
-    FILE *fp = fopen(fname, "rb");
-    if (!fp) {
-        perror("fopen failed");
-        return -1;
+// Separates "--option" flags from positional args; returns positional count
+static int parse_options(int argc, char *argv[], char **pos_args) {
+    int npos = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--", 2) != 0) {
+            if (npos >= 3) return -1;
+            pos_args[npos++] = argv[i];
+        } else if (strcmp(argv[i], "--early-abandon") == 0) {
+            opts.early_abandon = 1;
+        } else if (strcmp(argv[i], "--build-index") == 0) {
+            opts.build_index = 1;
+        } else if (strcmp(argv[i], "--query") == 0) {
+            opts.query = 1;
+        } else if (strcmp(argv[i], "--edit") == 0) {
+            opts.edit = 1;
+        } else if (strcmp(argv[i], "--time") == 0) {
+            opts.time = 1;
+        } else if (strcmp(argv[i], "--serve") == 0) {
+            opts.serve = 1;
+        } else if (strcmp(argv[i], "--client") == 0) {
+            opts.client = 1;
+        } else if (strcmp(argv[i], "--profile") == 0 && i + 1 < argc) {
+            opts.profile_file = argv[++i];
+        } else if (strcmp(argv[i], "--fasta-index") == 0) {
+            opts.fasta_index = 1;
+        } else if (strcmp(argv[i], "--contig") == 0 && i + 1 < argc) {
+            opts.contig = argv[++i];
+        } else if (strcmp(argv[i], "--iupac") == 0) {
+            opts.iupac = 1;
+        } else if (strcmp(argv[i], "--both-strands") == 0) {
+            opts.both_strands = 1;
+        } else if (strcmp(argv[i], "--instrument") == 0) {
+            opts.instrument = 1;
+        } else if (strcmp(argv[i], "--hugepages") == 0 && i + 1 < argc &&
+                   (strcmp(argv[i + 1], "thp") == 0 || strcmp(argv[i + 1], "explicit") == 0)) {
+            opts.hugepages = argv[++i];
+        } else if (strcmp(argv[i], "--numa-replicate") == 0) {
+            opts.numa_replicate = 1;
+        } else if (strcmp(argv[i], "--kernel") == 0 && i + 1 < argc &&
+                   (strcmp(argv[i + 1], "auto") == 0 || strcmp(argv[i + 1], "generic") == 0 ||
+                    strcmp(argv[i + 1], "packed") == 0 || strcmp(argv[i + 1], "tiled") == 0)) {
+            opts.kernel = argv[++i];
+        } else if (strcmp(argv[i], "--matrix") == 0 && i + 1 < argc) {
+            opts.matrix_file = argv[++i];
+        } else if (strcmp(argv[i], "--deadline") == 0 && i + 1 < argc && atof(argv[i + 1]) > 0.0) {
+            opts.deadline_ms = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--checkpoint") == 0 && i + 1 < argc) {
+            opts.checkpoint_file = argv[++i];
+        } else if (strcmp(argv[i], "--checkpoint-interval") == 0 && i + 1 < argc &&
+                   atof(argv[i + 1]) > 0.0) {
+            opts.checkpoint_ms = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc &&
+                   atof(argv[i + 1]) > 0.0 && atof(argv[i + 1]) <= 100.0) {
+            opts.filter_pct = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--resume") == 0) {
+            opts.resume = 1;
+        } else if (strcmp(argv[i], "--db") == 0) {
+            opts.db = 1;
+        } else if (strcmp(argv[i], "--backend") == 0 && i + 1 < argc &&
+                   (strcmp(argv[i + 1], "auto") == 0 || strcmp(argv[i + 1], "process") == 0 ||
+                    strcmp(argv[i + 1], "thread") == 0)) {
+            opts.backend = argv[++i];
+        } else {
+            fprintf(stderr, "unknown option '%s'\n", argv[i]);
+            return -1;
+        }
     }
+    return npos;
+}
 
-    // Temporary buffer for reading file
-    size_t cap = (MAX_SEQUENCE_SIZE > MAX_SUBSEQUENCE_SIZE ?
-                  MAX_SEQUENCE_SIZE : MAX_SUBSEQUENCE_SIZE) + 1;
-    char *tmp = (char *)malloc(cap);
-    if (!tmp) {
-        perror("malloc failed");
-        fclose(fp);
-        return -1;
-    }
+// Runs this worker's share of the search selected by the options
+static int run_worker(int worker_id, shared_results_t *res, sem_t *lock) {
+    if (opts.deadline_ms > 0.0)
+        return search_worker_deadline(worker_id, res, lock);
+    if (opts.checkpoint_file)
+        return search_worker_checkpointed(worker_id, res, lock);
+    if (opts.filter_pct > 0.0)
+        return search_worker_qgram(worker_id, res, lock);
+    if (opts.edit)
+        return search_edit(worker_id, res, lock);
+    if (opts.query)
+        return search_candidates(worker_id, res, lock);
+    if (profile_counts)
+        return search_worker_profile(worker_id, res, lock);
+    if (opts.matrix_file)
+        return search_worker_matrix(worker_id, res, lock);
+    if (opts.iupac)
+        return search_worker_iupac(worker_id, res, lock);
+    if (opts.both_strands)
+        return search_worker_both(worker_id, res, lock);
+    if (opts.early_abandon && !use_packed && !use_tiled)
+        return search_worker_bounded(worker_id, res, lock);
+    if (use_packed)
+        return search_worker_packed(worker_id, res, lock);
+    if (use_tiled)
+        return search_worker_tiled(worker_id, res, lock);
+    return search_worker(worker_id, res, lock);
+}
 
-    // Read file into buffer
-    size_t total = 0;
-    for (;;) {
-        size_t space = cap - total;
-        if (space == 0) break;
-        size_t n = fread(tmp + total, 1, space, fp);
-        total += n;
-        if (n < space) {
-            if (feof(fp)) break;
-            if (ferror(fp)) {
-                perror("fread failed");
-                free(tmp);
-                fclose(fp);
-                return -1;
-            }
+// Contiguous slice [lo, hi) of positions for layouts that sweep left to
+// right instead of interleaving
+static void worker_slice(int worker_id, size_t *lo, size_t *hi) {
+    *lo = seq_len * (size_t)worker_id / (size_t)num_procs;
+    *hi = seq_len * ((size_t)worker_id + 1) / (size_t)num_procs;
+}
+
+// Positions and base compares of one worker, derived from its layout
+static void worker_work(int worker_id, long long *positions, long long *bases) {
+    *positions = 0;
+    *bases = 0;
+    if (opts.edit) {
+        // DP columns including the 2m warm-up, each touching every row
+        size_t lo, hi;
+        worker_slice(worker_id, &lo, &hi);
+        size_t start = lo > 2 * subseq_len ? lo - 2 * subseq_len : 0;
+        if (lo < hi) {
+            *positions = (long long)(hi - start);
+            *bases = (long long)(hi - start) * (long long)subseq_len;
+        }
+        return;
+    }
+    if (opts.early_abandon && !use_packed && !use_tiled) {
+        *positions = ea_positions;
+        *bases = ea_compares;
+        return;
+    }
+    if (use_packed || use_tiled || profile_counts) {
+        size_t lo, hi;
+        worker_slice(worker_id, &lo, &hi);
+        for (size_t pos = lo; pos < hi; pos++) {
+            size_t avail = seq_len - pos;
+            *bases += (long long)(avail < subseq_len ? avail : subseq_len);
         }
+        *positions = (long long)(hi - lo);
+        return;
     }
-    fclose(fp);
+    size_t count = opts.query ? n_candidates : seq_len;
+    for (size_t k = (size_t)worker_id; k < count; k += (size_t)num_procs) {
+        size_t pos = opts.query ? candidates[k] : k;
+        size_t avail = seq_len - pos;
+        (*positions)++;
+        *bases += (long long)(avail < subseq_len ? avail : subseq_len);
+    }
+    if (opts.both_strands) *bases *= 2;
+}
 
-    // Allocate filtered output buffer
-    char *dst = (char *)malloc(max_keep + 1);
-    if (!dst) {
-        perror("malloc failed");
-        free(tmp);
-        return -1;
+// Runs the worker and fills its stats slot (after shared_results_t)
+static int run_worker_instrumented(int worker_id, shared_results_t *res, sem_t *lock) {
+    my_stats = (worker_stats_t *)(res + 1) + worker_id;
+
+    struct rusage ru0, ru1;
+    getrusage(RUSAGE_THREAD, &ru0);
+    double t0 = now_ms();
+    int rc = run_worker(worker_id, res, lock);
+    my_stats->wall_ms = now_ms() - t0;
+    getrusage(RUSAGE_THREAD, &ru1);
+
+    double cpu0 = (double)(ru0.ru_utime.tv_sec + ru0.ru_stime.tv_sec) * 1000.0 +
+                  (double)(ru0.ru_utime.tv_usec + ru0.ru_stime.tv_usec) / 1000.0;
+    double cpu1 = (double)(ru1.ru_utime.tv_sec + ru1.ru_stime.tv_sec) * 1000.0 +
+                  (double)(ru1.ru_utime.tv_usec + ru1.ru_stime.tv_usec) / 1000.0;
+    my_stats->cpu_ms = cpu1 - cpu0;
+    my_stats->minor_faults = ru1.ru_minflt - ru0.ru_minflt;
+    my_stats->major_faults = ru1.ru_majflt - ru0.ru_majflt;
+    worker_work(worker_id, &my_stats->positions, &my_stats->bases);
+    return rc;
+}
+
+// Prints the per-worker table, aggregate throughput and the imbalance
+// (slowest worker's wall time over the mean)
+static void print_worker_stats(const shared_results_t *res, double wall_ms) {
+    const worker_stats_t *ws = (const worker_stats_t *)(res + 1);
+    long long total_bases = 0;
+    double sum_wall = 0.0, max_wall = 0.0;
+
+    printf("%-6s %12s %14s %10s %10s %10s %8s %6s %10s\n", "Worker", "Positions", "Bases",
+           "Wall ms", "CPU ms", "Sem ms", "MinFlt", "MajFlt", "Mbase/s");
+    for (int i = 0; i < num_procs; i++) {
+        const worker_stats_t *w = &ws[i];
+        double rate = w->wall_ms > 0.0 ? (double)w->bases / (w->wall_ms * 1000.0) : 0.0;
+        printf("%-6d %12lld %14lld %10.3f %10.3f %10.3f %8ld %6ld %10.1f\n", i, w->positions,
+               w->bases, w->wall_ms, w->cpu_ms, w->sem_wait_ms, w->minor_faults,
+               w->major_faults, rate);
+        total_bases += w->bases;
+        sum_wall += w->wall_ms;
+        if (w->wall_ms > max_wall) max_wall = w->wall_ms;
     }
+    double mean_wall = num_procs > 0 ? sum_wall / num_procs : 0.0;
+    printf("Aggregate:           %.3f Gbase/s over %.3f ms\n",
+           wall_ms > 0.0 ? (double)total_bases / (wall_ms * 1e6) : 0.0, wall_ms);
+    printf("Imbalance:           %.2fx (slowest / mean worker)\n",
+           mean_wall > 0.0 ? max_wall / mean_wall : 0.0);
+}
 
-    // Copy only valid DNA bases
-    size_t keep = 0;
-    for (size_t i = 0; i < total; i++) {
-        char c = tmp[i];
-        if (c == 'A' || c == 'C' || c == 'G' || c == 'T') {
-            if (keep >= max_keep) {
-                fprintf(stderr, "file '%s' too big after filtering (max %zu)\n",
-                        fname, max_keep);
-                free(tmp);
-                free(dst);
-                return -1;
-            }
-            dst[keep++] = c;
-        } else if (c == 'a' || c == 'c' || c == 'g' || c == 't') {
-            if (keep >= max_keep) {
-                fprintf(stderr, "file '%s' too big after filtering (max %zu)\n",
-                        fname, max_keep);
-                free(tmp);
-                free(dst);
-                return -1;
-            }
-            dst[keep++] = (char)('A' + (c - 'a'));
+// Plain search: score every interleaved position in full
+static int search_worker(int worker_id, shared_results_t *res, sem_t *lock) {
+    int best_pos = -1;
+    int best_cnt = -1;
+
+    // Iterate through positions assigned to this process
+    for (size_t pos = (size_t)worker_id; pos < seq_len; pos += (size_t)num_procs) {
+        // Count matching characters between seq and subseq
+        int matches = count_matches(pos);
+
+        // Track best local match
+        if (matches > best_cnt) {
+            best_cnt = matches;
+            best_pos = (int)pos;
         }
     }
-    dst[keep] = '\0';
-    free(tmp);
 
-    *out = dst;
-    return (ssize_t)keep;
+    return publish_best(res, lock, best_pos, best_cnt);
 }
 
-// Cleans up shared memory, semaphores, and allocated memory
-static void cleanup_parent(void) {
-    if (seq)      { free(seq);    seq = NULL; }
-    if (subseq)   { free(subseq); subseq = NULL; }
-    if (g_results && g_results != MAP_FAILED) {
-        munmap(g_results, sizeof(*g_results));
-        g_results = NULL;
+// Profile search: full scan that also stores every position's count.
+// Workers own contiguous slices, so the stores need no locking and no
+// two workers write the same cache line except at a slice edge.
+static int search_worker_profile(int worker_id, shared_results_t *res, sem_t *lock) {
+    size_t lo, hi;
+    worker_slice(worker_id, &lo, &hi);
+    int best_pos = -1;
+    int best_cnt = -1;
+
+    for (size_t pos = lo; pos < hi; pos++) {
+        int matches = count_matches(pos);
+        profile_counts[pos] = (uint16_t)matches;
+        if (matches > best_cnt) {
+            best_cnt = matches;
+            best_pos = (int)pos;
+        }
     }
-    if (shm_fd != -1) {
-        close(shm_fd);
-        shm_fd = -1;
+
+    return publish_best(res, lock, best_pos, best_cnt);
+}
+
+// Seeds the bounded scan: scores the first EA_BLOCK bases of every
+// position of the worker, then the EA_SEEDS best of those in full, so a
+// strong match anywhere in the slice bounds the scan from its start.
+// Sets *best_pos/*best_cnt and returns the bases compared.
+static long long seed_bound(int worker_id, int *best_pos, int *best_cnt) {
+    int seed_pos[EA_SEEDS];
+    int seed_cnt[EA_SEEDS];
+    int seeds = 0, low = 0;
+    long long done = 0;
+
+    for (size_t pos = (size_t)worker_id; pos < seq_len; pos += (size_t)num_procs) {
+        size_t avail = seq_len - pos;
+        size_t n = avail < EA_BLOCK ? avail : EA_BLOCK;
+        int c = (int)count_span(seq + pos, subseq, n);
+        done += (long long)n;
+        if (seeds < EA_SEEDS) {
+            seed_pos[seeds] = (int)pos;
+            seed_cnt[seeds++] = c;
+        } else if (c > seed_cnt[low]) {
+            seed_pos[low] = (int)pos;
+            seed_cnt[low] = c;
+        } else {
+            continue;
+        }
+        for (int i = 0; i < seeds; i++)
+            if (seed_cnt[i] < seed_cnt[low]) low = i;
+    }
+
+    for (int i = 0; i < seeds; i++) {
+        size_t avail = seq_len - (size_t)seed_pos[i];
+        int c = count_matches((size_t)seed_pos[i]);
+        done += (long long)(avail < subseq_len ? avail : subseq_len);
+        if (c > *best_cnt || (c == *best_cnt && seed_pos[i] < *best_pos)) {
+            *best_cnt = c;
+            *best_pos = seed_pos[i];
+        }
+    }
+    return done;
+}
+
+// Branch-and-bound search: an alignment is dropped as soon as its matches
+// plus the bases left to compare cannot beat the bound. The bound is the
+// local best (one below it before the best's position, where a tie still
+// wins) or one below the global best read from shared memory (an earlier
+// position may still win a tie there). Blocks are scored with the SSE2
+// counter. Pruning only bites once the bound is near the best score, so
+// seed_bound() finds a strong local match before the scan starts; without
+// one (no close match in the text) the scan costs about a plain one.
+static int search_worker_bounded(int worker_id, shared_results_t *res, sem_t *lock) {
+    int best_pos = -1;
+    int best_cnt = -1;
+    int published_cnt = -1;
+    int global_cnt = -1;
+    long long done = 0;
+    size_t since_sync = 0;
+
+    if (subseq_len > EA_BLOCK) {
+        done = seed_bound(worker_id, &best_pos, &best_cnt);
+        if (publish_best(res, lock, best_pos, best_cnt) != 0) return 1;
+        published_cnt = best_cnt;
+        global_cnt = __atomic_load_n(&res->best_count, __ATOMIC_RELAXED);
+    }
+
+    for (size_t pos = (size_t)worker_id; pos < seq_len; pos += (size_t)num_procs) {
+        // Periodically share our best and pick up everyone else's
+        if (++since_sync >= EA_SYNC_POSITIONS) {
+            since_sync = 0;
+            if (best_cnt > published_cnt) {
+                if (publish_best(res, lock, best_pos, best_cnt) != 0) return 1;
+                published_cnt = best_cnt;
+            }
+            global_cnt = __atomic_load_n(&res->best_count, __ATOMIC_RELAXED);
+        }
+        int local = (int)pos < best_pos ? best_cnt - 1 : best_cnt;
+        int bound = local > global_cnt - 1 ? local : global_cnt - 1;
+
+        // Bases available shrink toward the tail, so once even a perfect
+        // score cannot beat the bound no later position can either
+        size_t avail = seq_len - pos;
+        size_t n = avail < subseq_len ? avail : subseq_len;
+        if ((long long)n <= (long long)bound) break;
+
+        // Score a block at a time, checking the bound between blocks
+        const char *s = seq + pos;
+        int matches = 0;
+        size_t j = 0;
+        while (j < n) {
+            size_t len = n - j < EA_BLOCK ? n - j : EA_BLOCK;
+            matches += (int)count_span(s + j, subseq + j, len);
+            j += len;
+            if ((long long)matches + (long long)(n - j) <= (long long)bound) break;
+        }
+        done += (long long)j;
+        ea_positions++;
+
+        if (j == n && (matches > best_cnt || (matches == best_cnt && (int)pos < best_pos))) {
+            best_cnt = matches;
+            best_pos = (int)pos;
+        }
+    }
+
+    int rc = publish_best(res, lock, best_pos, best_cnt);
+    __atomic_fetch_add(&res->compares_done, done, __ATOMIC_RELAXED);
+    ea_compares = done;
+    return rc;
+}
+
+#ifdef __SSE2__
+// Sums the 16 unsigned byte counters in acc
+static inline size_t hsum_epu8(__m128i acc) {
+    __m128i sums = _mm_sad_epu8(acc, _mm_setzero_si128());
+    return (size_t)_mm_cvtsi128_si32(sums) + (size_t)_mm_extract_epi16(sums, 4);
+}
+#endif
+
+// Counts equal bytes of s[0..n) and p[0..n)
+static size_t count_span(const char *s, const char *p, size_t n) {
+    size_t matches = 0;
+    size_t j = 0;
+#ifdef __SSE2__
+    // Byte counters (cmpeq gives -1 per match) flushed before they wrap
+    while (j + 16 <= n) {
+        size_t stop = j + 16 * 255 < n ? j + 16 * 255 : n;
+        __m128i acc = _mm_setzero_si128();
+        for (; j + 16 <= stop; j += 16)
+            acc = _mm_sub_epi8(acc, _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(s + j)),
+                                                   _mm_loadu_si128((const __m128i *)(p + j))));
+        matches += hsum_epu8(acc);
+    }
+#endif
+    for (; j < n; j++)
+        matches += (s[j] == p[j]);
+    return matches;
+}
+
+// Counts matching bases for the alignment starting at pos
+static int count_matches(size_t pos) {
+    if (opts.iupac) return count_matches_iupac(pos);
+    size_t avail = seq_len - pos;
+    size_t n = avail < subseq_len ? avail : subseq_len;
+    return (int)count_span(seq + pos, subseq, n);
+}
+
+// Two-strand search: each loaded base of seq is compared against the
+// pattern and its reverse complement in the same loop. Ties prefer the
+// lower position, then the forward strand.
+static int search_worker_both(int worker_id, shared_results_t *res, sem_t *lock) {
+    int best_pos = -1;
+    int best_cnt = -1;
+    int best_strand = 0;
+
+    for (size_t pos = (size_t)worker_id; pos < seq_len; pos += (size_t)num_procs) {
+        size_t avail = seq_len - pos;
+        size_t n = avail < subseq_len ? avail : subseq_len;
+        const char *s = seq + pos;
+        size_t fwd = 0, rev = 0;
+        size_t j = 0;
+#ifdef __SSE2__
+        while (j + 16 <= n) {
+            size_t stop = j + 16 * 255 < n ? j + 16 * 255 : n;
+            __m128i acc_f = _mm_setzero_si128();
+            __m128i acc_r = _mm_setzero_si128();
+            for (; j + 16 <= stop; j += 16) {
+                __m128i t = _mm_loadu_si128((const __m128i *)(s + j));
+                acc_f = _mm_sub_epi8(acc_f, _mm_cmpeq_epi8(t, _mm_loadu_si128((const __m128i *)(subseq + j))));
+                acc_r = _mm_sub_epi8(acc_r, _mm_cmpeq_epi8(t, _mm_loadu_si128((const __m128i *)(subseq_rc + j))));
+            }
+            fwd += hsum_epu8(acc_f);
+            rev += hsum_epu8(acc_r);
+        }
+#endif
+        for (; j < n; j++) {
+            char c = s[j];
+            fwd += (c == subseq[j]);
+            rev += (c == subseq_rc[j]);
+        }
+
+        if ((int)fwd > best_cnt) {
+            best_cnt = (int)fwd;
+            best_pos = (int)pos;
+            best_strand = 0;
+        }
+        if ((int)rev > best_cnt) {
+            best_cnt = (int)rev;
+            best_pos = (int)pos;
+            best_strand = 1;
+        }
+    }
+
+    return publish_best_strand(res, lock, best_pos, best_cnt, best_strand);
+}
+
+// Packs the text and pattern for the short-pattern kernels. Base j of
+// the pattern sits in bits 2*(j%32) of word j/32; the masks select the
+// odd (low) bit of each valid base pair.
+static int setup_packed_kernel(void) {
+    size_t words = seq_len / DNA_BASES_PER_WORD + 4;   // slide reads past the end
+    seq_packed = (uint64_t *)calloc(words, sizeof(uint64_t));
+    if (!seq_packed) {
+        perror("calloc failed");
+        return 1;
+    }
+    dna_pack_2bit(seq, seq_len, seq_packed);
+
+    // The packed kernel reads only this copy of the text, so it gets the
+    // sequence's placement (huge pages, per-node replicas) too
+    if (seq_copy_count > 0) {
+        packed_copy_count = place_copies(seq_packed, words * sizeof(uint64_t), seq_copy_count,
+                                         packed_copies, &packed_copy_len);
+        if (packed_copy_count < seq_copy_count) return 1;
+        free(seq_packed);
+        seq_packed = (uint64_t *)packed_copies[0];
+    }
+
+    uint64_t packed_pat[PACKED_MAX_PATTERN / DNA_BASES_PER_WORD + 1];
+    dna_pack_2bit(subseq, subseq_len, packed_pat);
+    for (int w = 0; w < 2; w++) {
+        size_t first = (size_t)w * DNA_BASES_PER_WORD;
+        size_t n = subseq_len > first ? subseq_len - first : 0;
+        if (n > DNA_BASES_PER_WORD) n = DNA_BASES_PER_WORD;
+        pat_words[w] = n ? packed_pat[w] : 0;
+        pat_masks[w] = n == DNA_BASES_PER_WORD ? ODD_BITS
+                                               : ODD_BITS & ((1ull << (2 * n)) - 1);
+    }
+    use_packed = 1;
+    return 0;
+}
+
+// 2-bit code of text base i
+static inline uint64_t text_code(size_t i) {
+    return (seq_packed[i / DNA_BASES_PER_WORD] >> (2 * (i % DNA_BASES_PER_WORD))) & 3;
+}
+
+// Packed text bases [i, i + 32) as one word (funnel shift of two words)
+static inline uint64_t text_word(size_t i) {
+    size_t w = i / DNA_BASES_PER_WORD;
+    unsigned sh = (unsigned)(2 * (i % DNA_BASES_PER_WORD));
+    return (seq_packed[w] >> sh) | ((seq_packed[w + 1] << 1) << (63 - sh));
+}
+
+// Mismatching bases of one window word: XOR, fold each pair onto its low
+// bit, keep valid bases, count
+#define WORD_MISSES(win, w, mask) \
+    __builtin_popcountll(((((win) ^ pat_words[w]) | (((win) ^ pat_words[w]) >> 1)) & (mask)))
+
+// Short-pattern kernel over positions [lo, hi) with the pattern held in
+// 'words' registers (1: up to 32 bases, 2: up to 64). Inlined with a
+// constant 'words' so each length class compiles to its own loop.
+static inline __attribute__((always_inline))
+void packed_scan(size_t lo, size_t hi, int words, int *best_pos, int *best_cnt) {
+    const uint64_t p_mask0 = pat_masks[0], p_mask1 = pat_masks[1];
+    const int len = (int)subseq_len;
+    size_t full_end = seq_len >= subseq_len ? seq_len - subseq_len + 1 : 0;
+    if (full_end > hi) full_end = hi;
+    if (full_end < lo) full_end = lo;
+
+    uint64_t w0 = text_word(lo);
+    uint64_t w1 = words == 2 ? text_word(lo + DNA_BASES_PER_WORD) : 0;
+    size_t next = lo + (size_t)words * DNA_BASES_PER_WORD;
+    int bpos = *best_pos, bcnt = *best_cnt;
+
+    // Whole-pattern positions: fixed masks, one new base shifted in each
+    for (size_t pos = lo; pos < full_end; pos++, next++) {
+        int miss = WORD_MISSES(w0, 0, p_mask0);
+        if (words == 2) miss += WORD_MISSES(w1, 1, p_mask1);
+        if (len - miss > bcnt) {
+            bcnt = len - miss;
+            bpos = (int)pos;
+        }
+        uint64_t in = text_code(next);
+        if (words == 2) {
+            w0 = (w0 >> 2) | (w1 << 62);
+            w1 = (w1 >> 2) | (in << 62);
+        } else {
+            w0 = (w0 >> 2) | (in << 62);
+        }
+    }
+
+    // Tail positions where the pattern overhangs the text end
+    for (size_t pos = full_end; pos < hi; pos++) {
+        size_t avail = seq_len - pos;
+        uint64_t tail0 = avail >= DNA_BASES_PER_WORD ? ~0ull : (1ull << (2 * avail)) - 1;
+        uint64_t tail1 = avail >= 2 * DNA_BASES_PER_WORD ? ~0ull
+                       : avail <= DNA_BASES_PER_WORD ? 0
+                       : (1ull << (2 * (avail - DNA_BASES_PER_WORD))) - 1;
+        uint64_t t0 = text_word(pos);
+        int miss = WORD_MISSES(t0, 0, p_mask0 & tail0);
+        if (words == 2) {
+            uint64_t t1 = text_word(pos + DNA_BASES_PER_WORD);
+            miss += WORD_MISSES(t1, 1, p_mask1 & tail1);
+        }
+        int valid = (int)(avail < subseq_len ? avail : subseq_len);
+        if (valid - miss > bcnt) {
+            bcnt = valid - miss;
+            bpos = (int)pos;
+        }
+    }
+    *best_pos = bpos;
+    *best_cnt = bcnt;
+}
+
+// Length-class kernels, built with and without the popcnt instruction
+#if defined(__x86_64__) || defined(__i386__)
+#define KERNEL_POPCNT __attribute__((target("popcnt")))
+#else
+#define KERNEL_POPCNT
+#endif
+
+static void packed_scan_32(size_t lo, size_t hi, int *bp, int *bc) { packed_scan(lo, hi, 1, bp, bc); }
+static void packed_scan_64(size_t lo, size_t hi, int *bp, int *bc) { packed_scan(lo, hi, 2, bp, bc); }
+static KERNEL_POPCNT void packed_scan_32_popcnt(size_t lo, size_t hi, int *bp, int *bc) {
+    packed_scan(lo, hi, 1, bp, bc);
+}
+static KERNEL_POPCNT void packed_scan_64_popcnt(size_t lo, size_t hi, int *bp, int *bc) {
+    packed_scan(lo, hi, 2, bp, bc);
+}
+
+// Packed search: the window slides one base at a time, so each worker
+// takes a contiguous slice rather than interleaved positions
+static int search_worker_packed(int worker_id, shared_results_t *res, sem_t *lock) {
+    size_t lo, hi;
+    worker_slice(worker_id, &lo, &hi);
+    int best_pos = -1;
+    int best_cnt = -1;
+    if (lo >= hi) return 0;
+    packed_best(lo, hi, &best_pos, &best_cnt);
+    return publish_best(res, lock, best_pos, best_cnt);
+}
+
+// Four consecutive starts pos..pos+3 against pattern block [j0, j0 + n);
+// every window must cover the whole block. Adds to counts[0..3].
+static inline void tile_block4(size_t pos, size_t j0, size_t n, int *counts) {
+    const char *s = seq + pos + j0;
+    const char *p = subseq + j0;
+    size_t c0 = 0, c1 = 0, c2 = 0, c3 = 0;
+    size_t j = 0;
+#ifdef __SSE2__
+    __m128i a0 = _mm_setzero_si128(), a1 = a0, a2 = a0, a3 = a0;
+    for (; j + 16 <= n; j += 16) {
+        __m128i pv = _mm_loadu_si128((const __m128i *)(p + j));
+        a0 = _mm_sub_epi8(a0, _mm_cmpeq_epi8(pv, _mm_loadu_si128((const __m128i *)(s + j))));
+        a1 = _mm_sub_epi8(a1, _mm_cmpeq_epi8(pv, _mm_loadu_si128((const __m128i *)(s + j + 1))));
+        a2 = _mm_sub_epi8(a2, _mm_cmpeq_epi8(pv, _mm_loadu_si128((const __m128i *)(s + j + 2))));
+        a3 = _mm_sub_epi8(a3, _mm_cmpeq_epi8(pv, _mm_loadu_si128((const __m128i *)(s + j + 3))));
+    }
+    c0 = hsum_epu8(a0);
+    c1 = hsum_epu8(a1);
+    c2 = hsum_epu8(a2);
+    c3 = hsum_epu8(a3);
+#endif
+    for (; j < n; j++) {
+        c0 += (s[j] == p[j]);
+        c1 += (s[j + 1] == p[j]);
+        c2 += (s[j + 2] == p[j]);
+        c3 += (s[j + 3] == p[j]);
+    }
+    counts[0] += (int)c0;
+    counts[1] += (int)c1;
+    counts[2] += (int)c2;
+    counts[3] += (int)c3;
+}
+
+// One start against pattern block [j0, j0 + n), clipped at the text end
+static inline int tile_block1(size_t pos, size_t j0, size_t n) {
+    if (pos + j0 >= seq_len) return 0;
+    size_t avail = seq_len - pos - j0;
+    if (n > avail) n = avail;
+    const char *s = seq + pos + j0;
+    const char *p = subseq + j0;
+    int matches = 0;
+    for (size_t j = 0; j < n; j++)
+        matches += (s[j] == p[j]);
+    return matches;
+}
+
+// Tiled kernel over positions [lo, hi): per tile of starts, sweep the
+// pattern block by block with the partial counts held in L1
+static void tiled_best(size_t lo, size_t hi, int *best_pos, int *best_cnt) {
+    int counts[TILE_POSITIONS];
+    int bpos = *best_pos, bcnt = *best_cnt;
+    for (size_t p0 = lo; p0 < hi; p0 += TILE_POSITIONS) {
+        size_t np = hi - p0 < TILE_POSITIONS ? hi - p0 : TILE_POSITIONS;
+        memset(counts, 0, np * sizeof(int));
+        for (size_t j0 = 0; j0 < subseq_len; j0 += TILE_PATTERN) {
+            size_t n = subseq_len - j0 < TILE_PATTERN ? subseq_len - j0 : TILE_PATTERN;
+            size_t i = 0;
+            for (; i + 4 <= np && p0 + i + 3 + j0 + n <= seq_len; i += 4)
+                tile_block4(p0 + i, j0, n, counts + i);
+            for (; i < np; i++)
+                counts[i] += tile_block1(p0 + i, j0, n);
+        }
+        for (size_t i = 0; i < np; i++) {
+            if (counts[i] > bcnt) {
+                bcnt = counts[i];
+                bpos = (int)(p0 + i);
+            }
+        }
+    }
+    *best_pos = bpos;
+    *best_cnt = bcnt;
+}
+
+// Tiled search over a contiguous slice so tiles hold consecutive starts
+static int search_worker_tiled(int worker_id, shared_results_t *res, sem_t *lock) {
+    size_t lo, hi;
+    worker_slice(worker_id, &lo, &hi);
+    int best_pos = -1;
+    int best_cnt = -1;
+    if (lo >= hi) return 0;
+    tiled_best(lo, hi, &best_pos, &best_cnt);
+    return publish_best(res, lock, best_pos, best_cnt);
+}
+
+// Counts user-space read misses in one cache level (a
+// PERF_COUNT_HW_CACHE_* id) for this process and every thread or worker
+// it starts afterwards; returns the enabled counter's fd, or -1 with
+// errno set
+static int open_cache_counter(int cache) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = (unsigned long long)cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+// Prints the misses counted since the counters opened; exited workers
+// are folded into the totals once reaped
+static void print_cache_misses(int l1_fd, int llc_fd) {
+    unsigned long long l1 = 0, llc = 0;
+    if (l1_fd < 0 || llc_fd < 0 || read(l1_fd, &l1, sizeof(l1)) != (ssize_t)sizeof(l1) ||
+        read(llc_fd, &llc, sizeof(llc)) != (ssize_t)sizeof(llc)) {
+        printf("Cache Misses:        unavailable (no hardware cache counters)\n");
+    } else {
+        printf("Cache Misses:        %llu L1D reads, %llu LLC reads (%s kernel)\n", l1, llc,
+               use_tiled ? "tiled" : use_packed ? "packed" : "generic");
+    }
+    if (l1_fd >= 0) close(l1_fd);
+    if (llc_fd >= 0) close(llc_fd);
+}
+
+// Runs the length-class kernel for the pattern over [lo, hi)
+static void packed_best(size_t lo, size_t hi, int *best_pos, int *best_cnt) {
+    int has_popcnt = 0;
+#if defined(__x86_64__) || defined(__i386__)
+    has_popcnt = __builtin_cpu_supports("popcnt");
+#endif
+    if (subseq_len <= DNA_BASES_PER_WORD)
+        (has_popcnt ? packed_scan_32_popcnt : packed_scan_32)(lo, hi, best_pos, best_cnt);
+    else
+        (has_popcnt ? packed_scan_64_popcnt : packed_scan_64)(lo, hi, best_pos, best_cnt);
+}
+
+// IUPAC count: seq and subseq hold base-set masks, and a position
+// matches when the masks overlap, i.e. their AND is nonzero
+static int count_matches_iupac(size_t pos) {
+    size_t avail = seq_len - pos;
+    size_t n = avail < subseq_len ? avail : subseq_len;
+    const char *s = seq + pos;
+    size_t misses = 0;
+    size_t j = 0;
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+    for (; j + 16 <= n; j += 16) {
+        __m128i both = _mm_and_si128(_mm_loadu_si128((const __m128i *)(s + j)),
+                                     _mm_loadu_si128((const __m128i *)(subseq + j)));
+        misses += (size_t)__builtin_popcount((unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(both, zero)));
+    }
+#endif
+    for (; j < n; j++)
+        misses += (s[j] & subseq[j]) == 0;
+    return (int)(n - misses);
+}
+
+// IUPAC search: same interleaved layout as search_worker
+static int search_worker_iupac(int worker_id, shared_results_t *res, sem_t *lock) {
+    int best_pos = -1;
+    int best_cnt = -1;
+
+    for (size_t pos = (size_t)worker_id; pos < seq_len; pos += (size_t)num_procs) {
+        int matches = count_matches_iupac(pos);
+        if (matches > best_cnt) {
+            best_cnt = matches;
+            best_pos = (int)pos;
+        }
+    }
+
+    return publish_best(res, lock, best_pos, best_cnt);
+}
+
+// Reads a 4x4 (or, with --iupac, 16x16) substitution matrix. Tokens that
+// are not integers (row/column letters) and '#' comments are skipped.
+static int load_matrix(const char *fname) {
+    FILE *f = fopen(fname, "r");
+    if (!f) {
+        perror("fopen matrix failed");
+        return 1;
+    }
+    long vals[256];
+    int n = 0;
+    int bad = 0;
+    char line[1024];
+    while (fgets(line, sizeof(line), f)) {
+        char *hash = strchr(line, '#');
+        if (hash) *hash = '\0';
+        for (char *tok = strtok(line, " \t\r\n,"); tok; tok = strtok(NULL, " \t\r\n,")) {
+            char *end;
+            long v = strtol(tok, &end, 10);
+            if (end == tok || *end != '\0') continue;
+            if (n == 256 || v < -128 || v > 127) bad = 1;
+            else vals[n++] = v;
+        }
+    }
+    fclose(f);
+    if (bad || (n != 16 && !(n == 256 && opts.iupac))) {
+        fprintf(stderr, "matrix '%s' needs 16 entries%s in -128..127\n", fname,
+                opts.iupac ? " (or 256)" : "");
+        return 1;
+    }
+
+    // File order A C G T -> dna_code order A C T G
+    static const int code_of[4] = { 0, 1, 3, 2 };
+    static const unsigned mask_of[4] = { DNA_MASK_A, DNA_MASK_C, DNA_MASK_G, DNA_MASK_T };
+    int lo = 127, hi = -128;
+    if (n == 16) {
+        for (int r = 0; r < 4; r++)
+            for (int c = 0; c < 4; c++) {
+                int v = (int)vals[r * 4 + c];
+                score_table[code_of[r] * 4 + code_of[c]] = (int8_t)v;
+                if (v < lo) lo = v;
+                if (v > hi) hi = v;
+            }
+    }
+    if (hi - lo > 255) {
+        fprintf(stderr, "matrix '%s' spans more than 255\n", fname);
+        return 1;
+    }
+    score_bias = lo;
+    for (int i = 0; i < 16; i++) score_biased[i] = (uint8_t)(score_table[i] - lo);
+
+    // IUPAC: best scoring member pair of the two base sets
+    if (opts.iupac) {
+        for (unsigned sm = 0; sm < 16; sm++)
+            for (unsigned pm = 0; pm < 16; pm++) {
+                if (n == 256) {
+                    iupac_score_table[sm * 16 + pm] = (int16_t)vals[sm * 16 + pm];
+                    continue;
+                }
+                int best = INT_MIN;
+                for (int r = 0; r < 4; r++)
+                    for (int c = 0; c < 4; c++)
+                        if ((sm & mask_of[r]) && (pm & mask_of[c]) &&
+                            vals[r * 4 + c] > best)
+                            best = (int)vals[r * 4 + c];
+                iupac_score_table[sm * 16 + pm] = (int16_t)(best == INT_MIN ? lo : best);
+            }
+    }
+    return 0;
+}
+
+// Weighted score for the alignment at pos: one table lookup per base
+static int score_scalar(size_t pos) {
+    size_t avail = seq_len - pos;
+    size_t n = avail < subseq_len ? avail : subseq_len;
+    const char *s = seq + pos;
+    int score = 0;
+    if (opts.iupac) {
+        for (size_t j = 0; j < n; j++)
+            score += iupac_score_table[(unsigned char)s[j] * 16 + (unsigned char)subseq[j]];
+    } else {
+        for (size_t j = 0; j < n; j++)
+            score += score_table[(dna_code(s[j]) << 2) | (unsigned char)subseq_code[j]];
+    }
+    return score;
+}
+
+#ifdef __x86_64__
+// Shuffle version of score_scalar for A/C/G/T: index = ((s << 1) & 12) |
+// code(pat), one pshufb per 16 bases, biased bytes summed with SAD
+static __attribute__((target("ssse3"))) int score_ssse3(size_t pos) {
+    size_t avail = seq_len - pos;
+    size_t n = avail < subseq_len ? avail : subseq_len;
+    const char *s = seq + pos;
+    const __m128i table = _mm_loadu_si128((const __m128i *)score_biased);
+    const __m128i twelve = _mm_set1_epi8(12);
+    __m128i acc = _mm_setzero_si128();
+    size_t j = 0;
+    for (; j + 16 <= n; j += 16) {
+        __m128i sv = _mm_loadu_si128((const __m128i *)(s + j));
+        __m128i idx = _mm_or_si128(_mm_and_si128(_mm_add_epi8(sv, sv), twelve),
+                                   _mm_loadu_si128((const __m128i *)(subseq_code + j)));
+        acc = _mm_add_epi64(acc, _mm_sad_epu8(_mm_shuffle_epi8(table, idx),
+                                              _mm_setzero_si128()));
+    }
+    long long sum = (long long)_mm_cvtsi128_si64(acc) +
+                    (long long)_mm_cvtsi128_si64(_mm_unpackhi_epi64(acc, acc));
+    sum += (long long)score_bias * (long long)j;
+    for (; j < n; j++)
+        sum += score_table[(dna_code(s[j]) << 2) | (unsigned char)subseq_code[j]];
+    return (int)sum;
+}
+#endif
+
+// Per-position scorer for the plain (or IUPAC) count or the matrix score
+static int (*position_scorer(void))(size_t) {
+    if (!opts.matrix_file) return count_matches;
+#ifdef __x86_64__
+    if (!opts.iupac && __builtin_cpu_supports("ssse3")) return score_ssse3;
+#endif
+    return score_scalar;
+}
+
+// Matrix search: interleaved layout, ranked by weighted score (ties keep
+// the lower position)
+static int search_worker_matrix(int worker_id, shared_results_t *res, sem_t *lock) {
+    int best_pos = -1;
+    int best_score = INT_MIN;
+    int (*score)(size_t) = position_scorer();
+
+    for (size_t pos = (size_t)worker_id; pos < seq_len; pos += (size_t)num_procs) {
+        int sc = score(pos);
+        if (sc > best_score) {
+            best_score = sc;
+            best_pos = (int)pos;
+        }
+    }
+
+    return publish_best(res, lock, best_pos, best_score);
+}
+
+// Deadline search: the worker's positions w + k*P are visited for k = 0,
+// S, 2S, ... (S = DEADLINE_COARSE), then k = S/2 + multiples of S, and so
+// on down to step 1, so an early stop still samples the whole sequence
+static int search_worker_deadline(int worker_id, shared_results_t *res, sem_t *lock) {
+    int (*score)(size_t) = position_scorer();
+    size_t count = (size_t)worker_id < seq_len
+        ? (seq_len - (size_t)worker_id + (size_t)num_procs - 1) / (size_t)num_procs : 0;
+    int best_pos = -1;
+    int best_score = INT_MIN;
+    int published = INT_MIN;
+    int published_pos = -1;
+    size_t check = subseq_len < DEADLINE_CHECK_BASES ? DEADLINE_CHECK_BASES / subseq_len : 1;
+    size_t since_check = 0;
+
+    for (size_t step = DEADLINE_COARSE; step > 0; step /= 2) {
+        size_t first = step == DEADLINE_COARSE ? 0 : step;
+        size_t inc = step == DEADLINE_COARSE ? step : 2 * step;
+        for (size_t k = first; k < count; k += inc) {
+            size_t pos = (size_t)worker_id + k * (size_t)num_procs;
+            int sc = score(pos);
+            // Later passes revisit lower positions, so ties compare them
+            if (sc > best_score || (sc == best_score && (int)pos < best_pos)) {
+                best_score = sc;
+                best_pos = (int)pos;
+            }
+            if (++since_check == check) {
+                since_check = 0;
+                __atomic_fetch_add(&res->positions_done, (long long)check, __ATOMIC_RELAXED);
+                // A tie moved to a lower position is an improvement too
+                if (best_score > published ||
+                    (best_score == published && best_pos < published_pos)) {
+                    if (publish_best(res, lock, best_pos, best_score) != 0) return 1;
+                    published = best_score;
+                    published_pos = best_pos;
+                }
+                if (__atomic_load_n(&res->cancel, __ATOMIC_RELAXED)) return 0;
+            }
+        }
+    }
+    __atomic_fetch_add(&res->positions_done, (long long)since_check, __ATOMIC_RELAXED);
+    return publish_best(res, lock, best_pos, best_score);
+}
+
+// Polls the children until they finish, raising the cancel flag once
+// the deadline (counted from program start) passes; the workers see it
+// within one check interval and publish before exiting. Sets *timed_out
+// if the flag was raised.
+static int wait_with_deadline(int started, int *timed_out) {
+    double deadline = t_program + opts.deadline_ms;
+    int live = started;
+    int failed = 0;
+    *timed_out = 0;
+    while (live > 0) {
+        int wstatus = 0;
+        pid_t pid = waitpid(-1, &wstatus, WNOHANG);
+        if (pid == -1) {
+            perror("waitpid failed");
+            return 1;
+        }
+        if (pid > 0) {
+            live--;
+            for (int i = 0; i < started; i++)
+                if (child_pids[i] == pid) child_pids[i] = 0;
+            if (!WIFEXITED(wstatus) || WEXITSTATUS(wstatus) != 0) failed = 1;
+            continue;
+        }
+        double now = now_ms();
+        if (!*timed_out && now >= deadline) {
+            __atomic_store_n(&g_results->cancel, 1, __ATOMIC_RELAXED);
+            *timed_out = 1;
+        }
+        usleep(DEADLINE_POLL_US);
+    }
+    if (failed) {
+        fprintf(stderr, "child process error\n");
+        return 1;
+    }
+    return 0;
+}
+
+// Checkpointed scan: the worker's interleaved positions in order, from
+// its slot's next_k, publishing progress to the slot every CKPT_BLOCK
+static int search_worker_checkpointed(int worker_id, shared_results_t *res, sem_t *lock) {
+    int (*score)(size_t) = position_scorer();
+    ckpt_slot_t *slot = (ckpt_slot_t *)((char *)res + ((char *)ckpt_slots - (char *)g_results)) +
+                        worker_id;
+    size_t count = (size_t)worker_id < seq_len
+        ? (seq_len - (size_t)worker_id + (size_t)num_procs - 1) / (size_t)num_procs : 0;
+    uint64_t packed = (uint64_t)slot->best;
+    int best_score = (int)(int32_t)(packed >> 32);
+    int best_pos = (int)(int32_t)(uint32_t)packed;
+    size_t k = (size_t)slot->next_k;
+
+    while (k < count) {
+        size_t stop = k + CKPT_BLOCK < count ? k + CKPT_BLOCK : count;
+        for (; k < stop; k++) {
+            size_t pos = (size_t)worker_id + k * (size_t)num_procs;
+            int sc = score(pos);
+            if (sc > best_score) {
+                best_score = sc;
+                best_pos = (int)pos;
+            }
+        }
+        // Best first, then progress: a snapshot's best covers its next_k
+        __atomic_store_n(&slot->best,
+                         (long long)((uint64_t)(uint32_t)best_score << 32 | (uint32_t)best_pos),
+                         __ATOMIC_RELAXED);
+        __atomic_store_n(&slot->next_k, (long long)k, __ATOMIC_RELEASE);
+    }
+    return publish_best(res, lock, best_pos, best_score);
+}
+
+// 64-bit FNV-1a, chained through h
+static uint64_t fnv1a(uint64_t h, const void *data, size_t n) {
+    const unsigned char *p = (const unsigned char *)data;
+    for (size_t i = 0; i < n; i++) {
+        h ^= p[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+// Fingerprint of everything a checkpoint's progress depends on; it
+// hashes the whole sequence, so it is taken once into ckpt_fp before
+// the workers start rather than on every write
+static uint64_t ckpt_fingerprint(void) {
+    uint64_t h = fnv1a(14695981039346656037ull, subseq, subseq_len);
+    int flags[2] = { opts.iupac, opts.matrix_file != NULL };
+    h = fnv1a(h, flags, sizeof(flags));
+    if (opts.matrix_file) {
+        h = fnv1a(h, score_table, sizeof(score_table));
+        h = fnv1a(h, iupac_score_table, sizeof(iupac_score_table));
+    }
+    if (opts.db) {
+        for (int f = 0; f < db_file_count; f++) {
+            h = fnv1a(h, db_paths[f], strlen(db_paths[f]) + 1);
+            h = fnv1a(h, &db_sizes[f], sizeof(db_sizes[f]));
+        }
+    } else {
+        h = fnv1a(h, seq, seq_len);
+    }
+    return h;
+}
+
+// Snapshots progress and replaces the checkpoint file atomically
+// (FILE.tmp, fsync, rename); returns 0 or -1
+static int write_checkpoint(void) {
+    double t0 = now_ms();
+    ckpt_header_t hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, CKPT_MAGIC, sizeof(hdr.magic));
+    hdr.mode = opts.db ? CKPT_DB : CKPT_SCAN;
+    hdr.workers = num_procs;
+    hdr.fingerprint = ckpt_fp;
+    hdr.entries = opts.db ? (uint64_t)g_db->task_count : (uint64_t)num_procs;
+    hdr.files = opts.db ? (uint64_t)db_file_count : 0;
+
+    size_t body = opts.db ? (size_t)hdr.entries * sizeof(ckpt_task_t) +
+                            (size_t)hdr.files * sizeof(db_file_hit_t)
+                          : (size_t)hdr.entries * sizeof(ckpt_slot_t);
+    char *buf = (char *)malloc(sizeof(hdr) + body);
+    if (!buf) {
+        perror("malloc failed");
+        return -1;
+    }
+    memcpy(buf, &hdr, sizeof(hdr));
+    if (opts.db) {
+        // Chunks and hits change together under the lock; skip this
+        // snapshot if a killed worker left it taken
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_sec += 1;
+        if (sem_timedwait(g_sem, &ts) == -1) {
+            free(buf);
+            return -1;
+        }
+        ckpt_task_t *ct = (ckpt_task_t *)(buf + sizeof(hdr));
+        for (uint64_t t = 0; t < hdr.entries; t++) {
+            ct[t].bases = db_tasks[t].bases;
+            ct[t].done = db_tasks[t].done;
+        }
+        memcpy(ct + hdr.entries, db_hits, (size_t)hdr.files * sizeof(db_file_hit_t));
+        sem_post(g_sem);
+    } else {
+        ckpt_slot_t *cs = (ckpt_slot_t *)(buf + sizeof(hdr));
+        for (int i = 0; i < num_procs; i++) {
+            cs[i].next_k = __atomic_load_n(&ckpt_slots[i].next_k, __ATOMIC_ACQUIRE);
+            cs[i].best = __atomic_load_n(&ckpt_slots[i].best, __ATOMIC_RELAXED);
+        }
+    }
+
+    char tmp[4096];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", opts.checkpoint_file);
+    int fd = open(tmp, O_CREAT | O_TRUNC | O_WRONLY, 0644);
+    int rc = fd == -1 ? -1 : 0;
+    if (rc == 0 && (write_full(fd, buf, sizeof(hdr) + body) != 0 || fsync(fd) != 0)) rc = -1;
+    if (fd != -1 && close(fd) != 0) rc = -1;
+    if (rc == 0 && rename(tmp, opts.checkpoint_file) != 0) rc = -1;
+    if (rc != 0) {
+        perror("checkpoint write failed");
+        unlink(tmp);
+    }
+    free(buf);
+    ckpt_writes += rc == 0;
+    ckpt_write_ms += now_ms() - t0;
+    return rc;
+}
+
+// Restores progress from the checkpoint file (a missing file starts a
+// fresh run); the shm slots or chunk table must already be set up
+static int load_checkpoint(void) {
+    int fd = open(opts.checkpoint_file, O_RDONLY);
+    if (fd == -1) {
+        if (errno == ENOENT) {
+            fprintf(stderr, "no checkpoint at %s; starting from the beginning\n",
+                    opts.checkpoint_file);
+            return 0;
+        }
+        perror("open checkpoint failed");
+        return 1;
+    }
+    struct stat st;
+    ckpt_header_t hdr;
+    char *buf = NULL;
+    int ok = fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(hdr);
+    if (ok) {
+        buf = (char *)malloc((size_t)st.st_size);
+        ok = buf && read_full(fd, buf, (size_t)st.st_size) == 0;
+    }
+    close(fd);
+    if (ok) {
+        memcpy(&hdr, buf, sizeof(hdr));
+        size_t body = hdr.mode == CKPT_DB ? (size_t)hdr.entries * sizeof(ckpt_task_t) +
+                                            (size_t)hdr.files * sizeof(db_file_hit_t)
+                                          : (size_t)hdr.entries * sizeof(ckpt_slot_t);
+        ok = memcmp(hdr.magic, CKPT_MAGIC, sizeof(hdr.magic)) == 0 &&
+             hdr.mode == (uint32_t)(opts.db ? CKPT_DB : CKPT_SCAN) &&
+             hdr.fingerprint == ckpt_fp &&
+             (size_t)st.st_size == sizeof(hdr) + body &&
+             (opts.db ? hdr.entries == (uint64_t)g_db->task_count &&
+                        hdr.files == (uint64_t)db_file_count
+                      : hdr.workers == num_procs && hdr.entries == (uint64_t)num_procs);
+    }
+    if (!ok) {
+        fprintf(stderr, "checkpoint %s does not match this run (inputs, options, num_procs)\n",
+                opts.checkpoint_file);
+        free(buf);
+        return 1;
+    }
+
+    double done = 0.0;
+    if (opts.db) {
+        const ckpt_task_t *ct = (const ckpt_task_t *)(buf + sizeof(hdr));
+        size_t chunks = 0;
+        for (uint64_t t = 0; t < hdr.entries; t++) {
+            db_tasks[t].bases = ct[t].bases;
+            db_tasks[t].done = ct[t].done;
+            chunks += ct[t].done != 0;
+        }
+        memcpy(db_hits, ct + hdr.entries, (size_t)hdr.files * sizeof(db_file_hit_t));
+        done = hdr.entries ? 100.0 * (double)chunks / (double)hdr.entries : 0.0;
+    } else {
+        memcpy(ckpt_slots, buf + sizeof(hdr), (size_t)num_procs * sizeof(ckpt_slot_t));
+        long long positions = 0;
+        for (int i = 0; i < num_procs; i++) positions += ckpt_slots[i].next_k;
+        done = seq_len ? 100.0 * (double)positions / (double)seq_len : 0.0;
+    }
+    free(buf);
+    ckpt_resumed = 1;
+    fprintf(stderr, "resuming from %s (%.2f%% done)\n", opts.checkpoint_file, done);
+    return 0;
+}
+
+// Blocks SIGCHLD/SIGTERM/SIGINT so the parent can sleep in sigtimedwait
+// between checkpoints; children restore ckpt_saved_mask after fork
+static void block_child_signals(void) {
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGCHLD);
+    sigaddset(&set, SIGTERM);
+    sigaddset(&set, SIGINT);
+    sigprocmask(SIG_BLOCK, &set, &ckpt_saved_mask);
+}
+
+// Waits for the children, writing a checkpoint every checkpoint_ms. On
+// SIGTERM/SIGINT writes a final one, kills the children and sets
+// *interrupted.
+static int wait_with_checkpoints(int started, int *interrupted) {
+    double interval = opts.checkpoint_ms > 0.0 ? opts.checkpoint_ms : CKPT_INTERVAL_MS;
+    double next = now_ms() + interval;
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGCHLD);
+    sigaddset(&set, SIGTERM);
+    sigaddset(&set, SIGINT);
+    int live = started;
+    int failed = 0;
+    *interrupted = 0;
+    while (live > 0) {
+        int wstatus = 0;
+        pid_t pid = waitpid(-1, &wstatus, WNOHANG);
+        if (pid == -1) {
+            perror("waitpid failed");
+            return 1;
+        }
+        if (pid > 0) {
+            live--;
+            if (!*interrupted && (!WIFEXITED(wstatus) || WEXITSTATUS(wstatus) != 0))
+                failed = 1;
+            continue;
+        }
+        if (*interrupted) {
+            sigtimedwait(&set, NULL, &(struct timespec){ 0, 10000000L });
+            continue;
+        }
+        double now = now_ms();
+        if (now >= next) {
+            write_checkpoint();
+            next = now + interval;
+            continue;
+        }
+        double wait = next - now;
+        struct timespec ts = { (time_t)(wait / 1000.0),
+                               (long)((wait - 1000.0 * (double)(time_t)(wait / 1000.0)) * 1e6) };
+        int sig = sigtimedwait(&set, NULL, &ts);
+        if (sig == SIGTERM || sig == SIGINT) {
+            write_checkpoint();
+            for (int i = 0; i < started; i++)
+                if (child_pids[i] > 0) kill(child_pids[i], SIGKILL);
+            *interrupted = 1;
+        }
+    }
+    if (failed) {
+        fprintf(stderr, "child process error\n");
+        return 1;
+    }
+    return 0;
+}
+
+// Hash slot of a q-gram code (multiplicative hash into the table)
+static inline uint32_t qgram_slot(uint32_t code) {
+    return (uint32_t)((code * 2654435761u) >> 7) & qg_mask_bits;
+}
+
+static int cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+// Picks q and the lemma threshold for the identity, and hashes the
+// pattern's q-grams to their offsets
+static int build_qgram_filter(void) {
+    size_t m = subseq_len;
+    size_t e = (size_t)((double)m * (100.0 - opts.filter_pct) / 100.0 + 1e-9);
+    qg_need = (int)(m - e);
+    // Largest q with a positive bound: (m - q + 1) - q*e >= 1
+    size_t q = m / (e + 1);
+    if (q > QGRAM_MAX_Q) q = QGRAM_MAX_Q;
+    if (q < 4) {
+        fprintf(stderr, "--filter %.1f is too loose for a %zu-base pattern (q would be %zu)\n",
+                opts.filter_pct, m, q);
+        return 1;
+    }
+    qg_q = (int)q;
+    qg_threshold = (int)((m - q + 1) - q * e);
+
+    // (code, offset) pairs sorted by code, then one hash slot per code
+    size_t n = m - q + 1;
+    uint64_t *pairs = (uint64_t *)malloc(n * sizeof(uint64_t));
+    uint32_t size = 1;
+    while (size < 2 * n) size <<= 1;
+    qg_mask_bits = size - 1;
+    qg_keys = (uint32_t *)malloc(size * sizeof(uint32_t));
+    qg_start = (uint32_t *)malloc(size * sizeof(uint32_t));
+    qg_count = (uint32_t *)calloc(size, sizeof(uint32_t));
+    qg_offsets = (uint32_t *)malloc(n * sizeof(uint32_t));
+    if (!pairs || !qg_keys || !qg_start || !qg_count || !qg_offsets) {
+        perror("malloc failed");
+        free(pairs);
+        return 1;
+    }
+    uint32_t qmask = (uint32_t)((1ull << (2 * q)) - 1);
+    uint32_t code = 0;
+    for (size_t j = 0; j < m; j++) {
+        code = ((code << 2) | dna_code(subseq[j])) & qmask;
+        if (j + 1 >= q) pairs[j + 1 - q] = (uint64_t)code << 32 | (uint32_t)(j + 1 - q);
+    }
+    qsort(pairs, n, sizeof(uint64_t), cmp_u64);
+    for (size_t i = 0; i < n; i++) {
+        uint32_t c = (uint32_t)(pairs[i] >> 32);
+        qg_offsets[i] = (uint32_t)pairs[i];
+        if (i > 0 && (uint32_t)(pairs[i - 1] >> 32) == c) continue;
+        uint32_t slot = qgram_slot(c);
+        while (qg_count[slot]) slot = (slot + 1) & qg_mask_bits;
+        qg_keys[slot] = c;
+        qg_start[slot] = (uint32_t)i;
+        size_t k = i;
+        while (k < n && (uint32_t)(pairs[k] >> 32) == c) k++;
+        qg_count[slot] = (uint32_t)(k - i);
+    }
+    free(pairs);
+    return 0;
+}
+
+// Filtered search over a contiguous slice of window starts: count the
+// aligned q-gram hits of every window, then score only windows at or
+// above the threshold and keep those reaching the identity
+static int search_worker_qgram(int worker_id, shared_results_t *res, sem_t *lock) {
+    size_t lo, hi;
+    worker_slice(worker_id, &lo, &hi);
+    size_t last = seq_len >= subseq_len ? seq_len - subseq_len + 1 : 0;   // full windows
+    if (hi > last) hi = last;
+    if (lo >= hi) return 0;
+
+    uint16_t *hits = (uint16_t *)calloc(hi - lo, sizeof(uint16_t));
+    if (!hits) {
+        perror("calloc failed");
+        return 1;
+    }
+
+    // Stage 1: text q-grams covering this slice's windows
+    size_t q = (size_t)qg_q;
+    uint32_t qmask = (uint32_t)((1ull << (2 * q)) - 1);
+    uint32_t code = 0;
+    size_t end = hi + subseq_len - 1;
+    for (size_t t = lo; t < end; t++) {
+        code = ((code << 2) | dna_code(seq[t])) & qmask;
+        if (t + 1 < lo + q) continue;
+        size_t start = t + 1 - q;
+        uint32_t slot = qgram_slot(code);
+        while (qg_count[slot] && qg_keys[slot] != code) slot = (slot + 1) & qg_mask_bits;
+        const uint32_t *off = qg_offsets + qg_start[slot];
+        for (uint32_t k = 0; k < qg_count[slot]; k++) {
+            // Window start = text q-gram start - pattern offset
+            if (start < (size_t)off[k]) continue;
+            size_t w = start - off[k];
+            if (w >= lo && w < hi) hits[w - lo]++;
+        }
+    }
+
+    // Stage 2: verify the survivors in position order
+    int best_pos = -1;
+    int best_cnt = -1;
+    long long passed = 0;
+    for (size_t w = lo; w < hi; w++) {
+        if (hits[w - lo] < qg_threshold) continue;
+        passed++;
+        int matches = count_matches(w);
+        if (matches >= qg_need && matches > best_cnt) {
+            best_cnt = matches;
+            best_pos = (int)w;
+        }
+    }
+    free(hits);
+    __atomic_fetch_add(&res->windows_passed, passed, __ATOMIC_RELAXED);
+    return publish_best(res, lock, best_pos, best_cnt);
+}
+
+// Query mode: verify interleaved candidates with the full match counter
+static int search_candidates(int worker_id, shared_results_t *res, sem_t *lock) {
+    int best_pos = -1;
+    int best_cnt = -1;
+
+    // Candidates are sorted, so ties keep the lowest position
+    for (size_t c = (size_t)worker_id; c < n_candidates; c += (size_t)num_procs) {
+        int matches = count_matches(candidates[c]);
+        if (matches > best_cnt) {
+            best_cnt = matches;
+            best_pos = (int)candidates[c];
+        }
+    }
+
+    return publish_best(res, lock, best_pos, best_cnt);
+}
+
+// Builds Myers' Peq bit vectors: bit r of block b for base c is set when
+// subseq[b * 64 + r] == c
+static int build_edit_peq(void) {
+    edit_blocks = (subseq_len + 63) / 64;
+    edit_peq = (uint64_t *)calloc(4 * edit_blocks, sizeof(uint64_t));
+    if (!edit_peq) {
+        perror("calloc failed");
+        return 1;
+    }
+    for (size_t j = 0; j < subseq_len; j++)
+        edit_peq[(size_t)dna_code(subseq[j]) * edit_blocks + j / 64] |= (uint64_t)1 << (j % 64);
+    return 0;
+}
+
+// Advances one 64-row block of Myers' algorithm by one text column, given
+// the horizontal delta entering at the top; returns the delta leaving the
+// row selected by 'high' (the block's last pattern row)
+static int myers_block(uint64_t *pv, uint64_t *mv, uint64_t eq, int hin, uint64_t high) {
+    uint64_t Pv = *pv, Mv = *mv;
+    uint64_t Xv = eq | Mv;
+    if (hin < 0) eq |= 1;
+    uint64_t Xh = (((eq & Pv) + Pv) ^ Pv) | eq;
+    uint64_t Ph = Mv | ~(Xh | Pv);
+    uint64_t Mh = Pv & Xh;
+
+    int hout = (Ph & high) ? 1 : (Mh & high) ? -1 : 0;
+
+    Ph <<= 1;
+    Mh <<= 1;
+    if (hin < 0) Mh |= 1;
+    else if (hin > 0) Ph |= 1;
+    *pv = Mh | ~(Xv | Ph);
+    *mv = Ph & Xv;
+    return hout;
+}
+
+// Edit mode: each worker owns a contiguous slice of end positions, since
+// the DP runs left to right. It starts 2 * subseq_len columns early so any
+// alignment ending in its slice (at most 2m bases long) is fully covered.
+static int search_edit(int worker_id, shared_results_t *res, sem_t *lock) {
+    size_t lo, hi;
+    worker_slice(worker_id, &lo, &hi);
+    if (lo >= hi) return 0;
+    size_t start = lo > 2 * subseq_len ? lo - 2 * subseq_len : 0;
+
+    uint64_t *pv = (uint64_t *)malloc(edit_blocks * sizeof(uint64_t));
+    uint64_t *mv = (uint64_t *)malloc(edit_blocks * sizeof(uint64_t));
+    if (!pv || !mv) {
+        perror("malloc failed");
+        free(pv);
+        free(mv);
+        return 1;
+    }
+    for (size_t b = 0; b < edit_blocks; b++) {
+        pv[b] = ~(uint64_t)0;
+        mv[b] = 0;
+    }
+
+    // Rows above the last block end at bit 63; the last ends at row m - 1
+    uint64_t last_high = (uint64_t)1 << ((subseq_len - 1) % 64);
+    int score = (int)subseq_len;
+    int best_pos = -1;
+    int best_dist = -1;
+
+    for (size_t j = start; j < hi; j++) {
+        const uint64_t *eq = edit_peq + (size_t)dna_code(seq[j]) * edit_blocks;
+        int h = 0;   // free start anywhere in the text: top row stays 0
+        for (size_t b = 0; b + 1 < edit_blocks; b++)
+            h = myers_block(&pv[b], &mv[b], eq[b], h, (uint64_t)1 << 63);
+        score += myers_block(&pv[edit_blocks - 1], &mv[edit_blocks - 1],
+                             eq[edit_blocks - 1], h, last_high);
+
+        if (j >= lo && (best_dist < 0 || score < best_dist)) {
+            best_dist = score;
+            best_pos = (int)j;
+        }
+    }
+    free(pv);
+    free(mv);
+
+    // Stored as -distance so the usual higher-is-better merge applies
+    return publish_best(res, lock, best_pos, -best_dist);
+}
+
+// Lock semaphore and merge a worker's best into shared memory
+static int publish_best(shared_results_t *res, sem_t *lock, int best_pos, int best_cnt) {
+    return publish_best_strand(res, lock, best_pos, best_cnt, 0);
+}
+
+// Same as publish_best for a hit on the given strand
+static int publish_best_strand(shared_results_t *res, sem_t *lock, int best_pos, int best_cnt,
+                               int strand) {
+    int rc = 0;
+    if (best_pos >= 0) {
+        double t_wait = my_stats ? now_ms() : 0.0;
+        int waited = sem_wait(lock);
+        if (my_stats) my_stats->sem_wait_ms += now_ms() - t_wait;
+        if (waited == -1) {
+            perror("sem_wait failed");
+            rc = 1;
+        } else {
+            // Update global best result if this one is better
+            if (best_cnt > res->best_count ||
+                (best_cnt == res->best_count && best_pos < res->best_position) ||
+                (best_cnt == res->best_count && best_pos == res->best_position &&
+                 strand < res->best_strand)) {
+                res->best_count    = best_cnt;
+                res->best_position = best_pos;
+                res->best_strand   = strand;
+            }
+            if (sem_post(lock) == -1) {
+                perror("sem_post failed");
+                rc = 1;
+            }
+        }
+    }
+    return rc;
+}
+
+// Compares a full scan performs: min(subseq_len, seq_len - pos) summed
+static long long full_compare_count(void) {
+    long long n = (long long)seq_len;
+    long long m = (long long)subseq_len;
+    if (n < m) return n * (n + 1) / 2;
+    return (n - m + 1) * m + m * (m - 1) / 2;
+}
+
+// Sorts uint32_t values for qsort
+static int cmp_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+// Builds the k-mer seed index (bucketed by counting sort) and writes it
+static int build_index(const char *seq_file, const char *index_file) {
+    ssize_t n_seq = dna_ingest_file(seq_file, MAX_SEQUENCE_SIZE, &seq, NULL);
+    if (n_seq < 0) return 1;
+    seq_len = (size_t)n_seq;
+
+    size_t n_kmers = seq_len >= KMER_K ? seq_len - KMER_K + 1 : 0;
+    uint32_t *offsets = (uint32_t *)calloc((size_t)KMER_BUCKETS + 1, sizeof(uint32_t));
+    uint32_t *positions = (uint32_t *)malloc((n_kmers ? n_kmers : 1) * sizeof(uint32_t));
+    if (!offsets || !positions) {
+        perror("malloc failed");
+        free(offsets);
+        free(positions);
+        cleanup_parent();
+        return 1;
+    }
+
+    // Count each k-mer, then prefix-sum the counts into bucket offsets
+    const uint32_t mask = KMER_BUCKETS - 1;
+    uint32_t kmer = 0;
+    for (size_t i = 0; i < seq_len; i++) {
+        kmer = ((kmer << 2) | (uint32_t)dna_code(seq[i])) & mask;
+        if (i + 1 >= KMER_K) offsets[kmer + 1]++;
+    }
+    for (uint32_t b = 0; b < KMER_BUCKETS; b++)
+        offsets[b + 1] += offsets[b];
+
+    // Scatter positions into their buckets (ascending within a bucket)
+    uint32_t *fill = (uint32_t *)malloc((size_t)KMER_BUCKETS * sizeof(uint32_t));
+    if (!fill) {
+        perror("malloc failed");
+        free(offsets);
+        free(positions);
+        cleanup_parent();
+        return 1;
+    }
+    memcpy(fill, offsets, (size_t)KMER_BUCKETS * sizeof(uint32_t));
+    kmer = 0;
+    for (size_t i = 0; i < seq_len; i++) {
+        kmer = ((kmer << 2) | (uint32_t)dna_code(seq[i])) & mask;
+        if (i + 1 >= KMER_K) positions[fill[kmer]++] = (uint32_t)(i + 1 - KMER_K);
+    }
+    free(fill);
+
+    // Header, then bucket offsets, positions and the filtered sequence
+    kmer_index_header_t hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, KMER_MAGIC, sizeof(hdr.magic));
+    hdr.k = KMER_K;
+    hdr.seq_len = (uint32_t)seq_len;
+    hdr.offsets_off = sizeof(hdr);
+    hdr.positions_off = hdr.offsets_off + ((uint64_t)KMER_BUCKETS + 1) * sizeof(uint32_t);
+    hdr.seq_off = hdr.positions_off + (uint64_t)n_kmers * sizeof(uint32_t);
+
+    int rc = 0;
+    FILE *fp = fopen(index_file, "wb");
+    if (!fp) {
+        perror("fopen failed");
+        rc = 1;
+    } else {
+        if (fwrite(&hdr, sizeof(hdr), 1, fp) != 1 ||
+            fwrite(offsets, sizeof(uint32_t), (size_t)KMER_BUCKETS + 1, fp) != (size_t)KMER_BUCKETS + 1 ||
+            fwrite(positions, sizeof(uint32_t), n_kmers, fp) != n_kmers ||
+            fwrite(seq, 1, seq_len, fp) != seq_len) {
+            perror("fwrite failed");
+            rc = 1;
+        }
+        if (fclose(fp) != 0 && rc == 0) {
+            perror("fclose failed");
+            rc = 1;
+        }
+    }
+
+    if (rc == 0)
+        printf("Indexed %zu bases (%zu %d-mers)\n", seq_len, n_kmers, KMER_K);
+    free(offsets);
+    free(positions);
+    cleanup_parent();
+    return rc;
+}
+
+// Maps an index file and points seq at the sequence stored inside it
+static int load_index(const char *index_file) {
+    int fd = open(index_file, O_RDONLY);
+    if (fd == -1) {
+        perror("open index failed");
+        return 1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == -1) {
+        perror("fstat failed");
+        close(fd);
+        return 1;
+    }
+    if ((size_t)st.st_size < sizeof(kmer_index_header_t)) {
+        fprintf(stderr, "index '%s' is truncated\n", index_file);
+        close(fd);
+        return 1;
+    }
+    void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        perror("mmap index failed");
+        return 1;
+    }
+    index_map = map;
+    index_map_len = (size_t)st.st_size;
+
+    // Check the header: the aligned bucket offsets and positions lie
+    // inside the file and the sequence runs exactly to its end
+    const kmer_index_header_t *hdr = (const kmer_index_header_t *)map;
+    uint64_t size = (uint64_t)st.st_size;
+    uint64_t n_kmers = hdr->seq_len >= KMER_K ? (uint64_t)hdr->seq_len - KMER_K + 1 : 0;
+    int ok = memcmp(hdr->magic, KMER_MAGIC, sizeof(hdr->magic)) == 0 && hdr->k == KMER_K &&
+             hdr->offsets_off % sizeof(uint32_t) == 0 && hdr->offsets_off <= size &&
+             (size - hdr->offsets_off) / sizeof(uint32_t) >= (uint64_t)KMER_BUCKETS + 1 &&
+             hdr->positions_off % sizeof(uint32_t) == 0 && hdr->positions_off <= size &&
+             (size - hdr->positions_off) / sizeof(uint32_t) >= n_kmers &&
+             hdr->seq_off <= size && size - hdr->seq_off == hdr->seq_len;
+
+    // Bucket offsets must rise to exactly n_kmers so every bucket stays
+    // inside the positions array
+    if (ok) {
+        const uint32_t *offsets = (const uint32_t *)((const char *)map + hdr->offsets_off);
+        for (uint32_t b = 0; ok && b < KMER_BUCKETS; b++) ok = offsets[b] <= offsets[b + 1];
+        ok = ok && offsets[KMER_BUCKETS] == n_kmers;
+    }
+    if (!ok) {
+        fprintf(stderr, "index '%s' is not a valid %d-mer index\n", index_file, KMER_K);
+        return 1;
+    }
+    seq = (char *)map + hdr->seq_off;
+    seq_len = hdr->seq_len;
+    return 0;
+}
+
+// Seed-and-extend: each non-overlapping pattern k-mer votes for the
+// alignment starts implied by its hits; falls back to every position
+// when the pattern is shorter than one seed or nothing seeds
+static int find_candidates(void) {
+    const kmer_index_header_t *hdr = (const kmer_index_header_t *)index_map;
+    const uint32_t *offsets = (const uint32_t *)((const char *)index_map + hdr->offsets_off);
+    const uint32_t *positions = (const uint32_t *)((const char *)index_map + hdr->positions_off);
+
+    size_t cap = 1024;
+    n_candidates = 0;
+    candidates = (uint32_t *)malloc(cap * sizeof(uint32_t));
+    if (!candidates) {
+        perror("malloc failed");
+        return 1;
+    }
+
+    for (size_t j = 0; j + KMER_K <= subseq_len; j += KMER_K) {
+        uint32_t kmer = 0;
+        for (size_t t = 0; t < KMER_K; t++)
+            kmer = (kmer << 2) | (uint32_t)dna_code(subseq[j + t]);
+        uint32_t lo = offsets[kmer], hi = offsets[kmer + 1];
+        if (hi - lo > KMER_MAX_HITS) continue;
+
+        for (uint32_t h = lo; h < hi; h++) {
+            // A corrupt position must not send a candidate past the text
+            if (positions[h] < j || positions[h] >= seq_len) continue;
+            if (n_candidates == cap) {
+                cap *= 2;
+                uint32_t *grown = (uint32_t *)realloc(candidates, cap * sizeof(uint32_t));
+                if (!grown) {
+                    perror("realloc failed");
+                    return 1;
+                }
+                candidates = grown;
+            }
+            candidates[n_candidates++] = positions[h] - (uint32_t)j;
+        }
+    }
+
+    if (n_candidates == 0) {
+        // No usable seed: verify every position
+        free(candidates);
+        candidates = (uint32_t *)malloc(seq_len * sizeof(uint32_t));
+        if (!candidates) {
+            perror("malloc failed");
+            return 1;
+        }
+        for (size_t p = 0; p < seq_len; p++)
+            candidates[p] = (uint32_t)p;
+        n_candidates = seq_len;
+        return 0;
+    }
+
+    // Sort and drop duplicate starts
+    qsort(candidates, n_candidates, sizeof(uint32_t), cmp_u32);
+    size_t w = 0;
+    for (size_t r = 0; r < n_candidates; r++)
+        if (w == 0 || candidates[r] != candidates[w - 1])
+            candidates[w++] = candidates[r];
+    n_candidates = w;
+    return 0;
+}
+
+// Signal handler: ask the server loop to stop
+static void on_stop_signal(int sig) {
+    (void)sig;
+    stop_requested = 1;
+}
+
+// Reads or writes exactly n bytes on a socket or file; returns 0 on success
+static int read_full(int fd, void *buf, size_t n) {
+    char *p = (char *)buf;
+    while (n > 0) {
+        ssize_t r = read(fd, p, n);
+        if (r == 0) return -1;
+        if (r < 0) {
+            if (errno == EINTR && !stop_requested) continue;
+            return -1;
+        }
+        p += r;
+        n -= (size_t)r;
+    }
+    return 0;
+}
+
+static int write_full(int fd, const void *buf, size_t n) {
+    const char *p = (const char *)buf;
+    while (n > 0) {
+        ssize_t w = write(fd, p, n);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += w;
+        n -= (size_t)w;
+    }
+    return 0;
+}
+
+// Waits on a semaphore, retrying when a signal interrupts the wait
+static int sem_wait_retry(sem_t *sem) {
+    while (sem_wait(sem) == -1) {
+        if (errno != EINTR) return -1;
+    }
+    return 0;
+}
+
+// Pool worker: sleeps on the start semaphore, claims the next unsearched
+// slice of the job, searches it, then reports on the done semaphore.
+// A start token is not tied to a worker (a fast one may take two in a
+// query), so the slice comes from the shared counter, not the worker id.
+static void server_worker(void) {
+    signal(SIGINT, SIG_IGN);
+    signal(SIGTERM, SIG_IGN);
+    for (;;) {
+        if (sem_wait_retry(g_start_sem) == -1) _exit(1);
+        if (g_job->shutdown) _exit(0);
+        if (sem_wait_retry(g_sem) == -1) _exit(1);
+        int slice = g_job->next_slice++;
+        sem_post(g_sem);
+        subseq = g_job->pattern;
+        subseq_len = g_job->pattern_len;
+        if (run_worker(slice, &g_job->results, g_sem) != 0)
+            __atomic_store_n(&g_job->failed, 1, __ATOMIC_RELAXED);
+        if (sem_post(g_done_sem) == -1) _exit(1);
+    }
+}
+
+// Reaps any pool worker that has exited, clearing its child_pids slot;
+// returns 1 if one had
+static int pool_lost(void) {
+    int lost = 0;
+    pid_t pid;
+    while ((pid = waitpid(-1, NULL, WNOHANG)) > 0) {
+        for (int i = 0; i < num_procs; i++)
+            if (child_pids[i] == pid) child_pids[i] = 0;
+        lost = 1;
+    }
+    return lost;
+}
+
+// Forks a worker for every empty child_pids slot; the children close
+// the server's sockets. Returns the number of workers running.
+static int spawn_pool(int lfd, int cfd) {
+    int running = 0;
+    for (int i = 0; i < num_procs; i++) {
+        if (child_pids[i] > 0) {
+            running++;
+            continue;
+        }
+        pid_t pid = fork();
+        if (pid == 0) {
+            close(lfd);
+            if (cfd >= 0) close(cfd);
+            server_worker();
+        } else if (pid > 0) {
+            child_pids[i] = pid;
+            running++;
+        } else {
+            perror("fork failed");
+        }
+    }
+    return running;
+}
+
+// Replaces the pool after a worker died: every worker is killed and
+// reaped, the semaphores are reset (a killed worker may hold the result
+// lock) and a fresh pool forked. Returns 0 if all run again.
+static int restart_pool(int lfd, int cfd) {
+    fprintf(stderr, "pool worker died; restarting the pool\n");
+    for (int i = 0; i < num_procs; i++)
+        if (child_pids[i] > 0) kill(child_pids[i], SIGKILL);
+    for (int i = 0; i < num_procs; i++) {
+        if (child_pids[i] > 0) waitpid(child_pids[i], NULL, 0);
+        child_pids[i] = 0;
+    }
+    while (sem_trywait(g_start_sem) == 0) {}
+    while (sem_trywait(g_done_sem) == 0) {}
+    while (sem_trywait(g_sem) == 0) {}
+    sem_post(g_sem);
+    return spawn_pool(lfd, cfd) == num_procs ? 0 : -1;
+}
+
+// Runs one query through the warm worker pool; a worker dying during it
+// fails the query with status 2 and sets *lost
+static void serve_query(const char *raw, size_t n, query_reply_t *reply, int *lost) {
+    memset(reply, 0, sizeof(*reply));
+    ssize_t len = dna_filter(raw, n, g_job->pattern, MAX_SUBSEQUENCE_SIZE);
+    if (len <= 0) {
+        reply->status = 1;
+        return;
+    }
+    g_job->pattern_len = (size_t)len;
+    g_job->results.best_position = -1;
+    g_job->results.best_count = -1;
+    g_job->failed = 0;
+    g_job->next_slice = 0;
+
+    // Semaphore post/wait order the job writes against the workers
+    for (int i = 0; i < num_procs; i++)
+        sem_post(g_start_sem);
+    for (int done = 0; done < num_procs;) {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_nsec += SERVER_POLL_MS * 1000000L;
+        if (ts.tv_nsec >= 1000000000L) { ts.tv_sec++; ts.tv_nsec -= 1000000000L; }
+        if (sem_timedwait(g_done_sem, &ts) == 0) {
+            done++;
+        } else if ((errno != ETIMEDOUT && errno != EINTR) || pool_lost()) {
+            *lost = 1;
+            reply->status = 2;
+            return;
+        }
+    }
+
+    reply->status = g_job->failed ? 2 : 0;
+    reply->best_position = g_job->results.best_position;
+    reply->best_count = g_job->results.best_count;
+}
+
+// Server mode: load the sequence once, fork a persistent worker pool and
+// answer queries on a Unix-domain socket until SIGINT/SIGTERM
+static int serve(const char *seq_file, const char *sock_path) {
+    ssize_t n_seq = dna_ingest_file(seq_file, MAX_SEQUENCE_SIZE, &seq, NULL);
+    if (n_seq < 0) return 1;
+    seq_len = (size_t)n_seq;
+    if (seq_len == 0) {
+        fprintf(stderr, "empty sequence\n");
+        cleanup_parent();
+        return 1;
+    }
+
+    // Job block in shared memory; the mapping is inherited by the workers
+    pid_t self = getpid();
+    snprintf(shm_name, sizeof(shm_name), "/dna_results_%ld", (long)self);
+    snprintf(sem_name, sizeof(sem_name), "/dna_lock_%ld", (long)self);
+    snprintf(start_sem_name, sizeof(start_sem_name), "/dna_start_%ld", (long)self);
+    snprintf(done_sem_name, sizeof(done_sem_name), "/dna_done_%ld", (long)self);
+    shm_fd = shm_open(shm_name, O_CREAT | O_EXCL | O_RDWR, 0666);
+    if (shm_fd == -1) {
+        perror("shm_open failed");
+        shm_name[0] = '\0';
+        cleanup_parent();
+        return 1;
+    }
+    shm_len = sizeof(server_job_t);
+    if (ftruncate(shm_fd, (off_t)shm_len) == -1) {
+        perror("ftruncate failed");
+        cleanup_parent();
+        return 1;
+    }
+    g_job = (server_job_t *)mmap(NULL, shm_len, PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0);
+    if (g_job == MAP_FAILED) {
+        perror("mmap failed");
+        g_job = NULL;
+        cleanup_parent();
+        return 1;
+    }
+    g_results = &g_job->results;
+
+    g_sem = sem_open(sem_name, O_CREAT | O_EXCL, 0666, 1);
+    g_start_sem = sem_open(start_sem_name, O_CREAT | O_EXCL, 0666, 0);
+    g_done_sem = sem_open(done_sem_name, O_CREAT | O_EXCL, 0666, 0);
+    if (g_sem == SEM_FAILED || g_start_sem == SEM_FAILED || g_done_sem == SEM_FAILED) {
+        perror("sem_open failed");
+        cleanup_parent();
+        return 1;
+    }
+
+    // Listening socket
+    int lfd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (lfd == -1) {
+        perror("socket failed");
+        cleanup_parent();
+        return 1;
+    }
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(sock_path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "socket path too long\n");
+        close(lfd);
+        cleanup_parent();
+        return 1;
+    }
+    strcpy(addr.sun_path, sock_path);
+    unlink(sock_path);
+    if (bind(lfd, (struct sockaddr *)&addr, sizeof(addr)) == -1 || listen(lfd, 16) == -1) {
+        perror("bind/listen failed");
+        close(lfd);
+        cleanup_parent();
+        return 1;
+    }
+
+    // Warm worker pool
+    child_pids = (pid_t *)calloc((size_t)num_procs, sizeof(pid_t));
+    if (!child_pids) {
+        perror("calloc failed");
+        close(lfd);
+        unlink(sock_path);
+        cleanup_parent();
+        return 1;
+    }
+    int started = spawn_pool(lfd, -1);
+
+    // Stop cleanly on SIGINT/SIGTERM (no SA_RESTART so accept returns)
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_stop_signal;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    char *raw = (char *)malloc(SERVER_MAX_REQUEST);
+    if (!raw) perror("malloc failed");
+    if (started == num_procs && raw)
+        fprintf(stderr, "serving %zu bases on %s with %d workers\n", seq_len, sock_path, num_procs);
+
+    // One connection at a time; each may carry any number of queries, and
+    // a client silent for SERVER_IO_TIMEOUT_S is dropped so it cannot
+    // hold the server
+    while (started == num_procs && raw && !stop_requested) {
+        int cfd = accept(lfd, NULL, NULL);
+        if (cfd == -1) {
+            if (errno == EINTR) continue;
+            perror("accept failed");
+            break;
+        }
+        struct timeval tv = { SERVER_IO_TIMEOUT_S, 0 };
+        setsockopt(cfd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        setsockopt(cfd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+        query_header_t hdr;
+        while (!stop_requested && read_full(cfd, &hdr, sizeof(hdr)) == 0) {
+            query_reply_t reply;
+            int lost = pool_lost();
+            if (lost && restart_pool(lfd, cfd) != 0) {
+                started = 0;
+                break;
+            }
+            if (hdr.magic != SERVER_MAGIC || hdr.len > SERVER_MAX_REQUEST) {
+                memset(&reply, 0, sizeof(reply));
+                reply.status = 1;
+                write_full(cfd, &reply, sizeof(reply));
+                break;
+            }
+            if (read_full(cfd, raw, hdr.len) != 0) break;
+            lost = 0;
+            serve_query(raw, hdr.len, &reply, &lost);
+            if (lost && restart_pool(lfd, cfd) != 0) {
+                started = 0;
+                break;
+            }
+            if (write_full(cfd, &reply, sizeof(reply)) != 0) break;
+        }
+        close(cfd);
+    }
+    free(raw);
+    close(lfd);
+    unlink(sock_path);
+
+    // Wake every worker with the shutdown flag set and reap them
+    g_job->shutdown = 1;
+    int rc = started == num_procs ? 0 : 1;
+    for (int i = 0; i < num_procs; i++)
+        if (child_pids[i] > 0) sem_post(g_start_sem);
+    for (int i = 0; i < num_procs; i++)
+        if (child_pids[i] > 0) waitpid(child_pids[i], NULL, 0);
+    cleanup_parent();
+    return rc;
+}
+
+// Sorts doubles for qsort
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Client mode: sends the same query 'iterations' times over one
+// connection and reports the answer plus p50/p99 round-trip latency
+static int client(const char *sock_path, const char *subseq_file, int iterations) {
+    ssize_t n_sub = dna_ingest_file(subseq_file, MAX_SUBSEQUENCE_SIZE, &subseq, NULL);
+    if (n_sub < 0) return 1;
+    subseq_len = (size_t)n_sub;
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd == -1) {
+        perror("socket failed");
+        cleanup_parent();
+        return 1;
+    }
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, sock_path, sizeof(addr.sun_path) - 1);
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == -1) {
+        perror("connect failed");
+        close(fd);
+        cleanup_parent();
+        return 1;
+    }
+
+    double *lat = (double *)malloc((size_t)iterations * sizeof(double));
+    if (!lat) {
+        perror("malloc failed");
+        close(fd);
+        cleanup_parent();
+        return 1;
+    }
+
+    query_header_t hdr = { SERVER_MAGIC, (uint32_t)subseq_len };
+    query_reply_t reply;
+    memset(&reply, 0, sizeof(reply));
+    int rc = 0;
+    for (int it = 0; it < iterations; it++) {
+        double t0 = now_ms();
+        if (write_full(fd, &hdr, sizeof(hdr)) != 0 ||
+            write_full(fd, subseq, subseq_len) != 0 ||
+            read_full(fd, &reply, sizeof(reply)) != 0) {
+            fprintf(stderr, "server connection lost\n");
+            rc = 1;
+            break;
+        }
+        lat[it] = now_ms() - t0;
+        if (reply.status != 0) {
+            fprintf(stderr, "server rejected query (status %d)\n", (int)reply.status);
+            rc = 1;
+            break;
+        }
+    }
+    close(fd);
+
+    if (rc == 0) {
+        qsort(lat, (size_t)iterations, sizeof(double), cmp_double);
+        printf("Best Match Position: %d\n", (int)reply.best_position);
+        printf("Best Match Count:    %d\n", (int)reply.best_count);
+        printf("Latency p50:         %.3f ms\n", lat[(size_t)(iterations - 1) * 50 / 100]);
+        printf("Latency p99:         %.3f ms\n", lat[(size_t)(iterations - 1) * 99 / 100]);
+    }
+    free(lat);
+    cleanup_parent();
+    return rc;
+}
+
+// Maps len bytes for a sequence copy, honoring --hugepages; returns NULL
+// on failure. Explicit huge pages fall back to THP when none are free.
+static char *map_sequence_copy(size_t len) {
+    static int hugetlb_failed = 0;
+    if (opts.hugepages && strcmp(opts.hugepages, "explicit") == 0 && !hugetlb_failed) {
+        void *p = mmap(NULL, len, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p != MAP_FAILED) {
+            seq_page_kind = "explicit 2MB";
+            return (char *)p;
+        }
+        // don't retry (or repeat the note) for the other copies
+        hugetlb_failed = 1;
+        fprintf(stderr, "note: MAP_HUGETLB failed (%s), using thp\n", strerror(errno));
+    }
+
+    // Over-map by one huge page and trim so the copy is 2MB aligned
+    size_t span = len + HUGE_PAGE_SIZE;
+    char *raw = (char *)mmap(NULL, span, PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) {
+        perror("mmap failed");
+        return NULL;
+    }
+    uintptr_t base = ((uintptr_t)raw + HUGE_PAGE_SIZE - 1) & ~(uintptr_t)(HUGE_PAGE_SIZE - 1);
+    char *p = (char *)base;
+    if (p > raw) munmap(raw, (size_t)(p - raw));
+    if (raw + span > p + len) munmap(p + len, (size_t)(raw + span - (p + len)));
+
+    if (opts.hugepages) {
+        if (madvise(p, len, MADV_HUGEPAGE) == 0) seq_page_kind = "thp";
+        else fprintf(stderr, "note: MADV_HUGEPAGE failed (%s)\n", strerror(errno));
+    }
+    return p;
+}
+
+// Parses a sysfs cpulist such as "0-3,8-11" into set
+static void parse_cpulist(const char *list, cpu_set_t *set) {
+    CPU_ZERO(set);
+    const char *p = list;
+    while (*p) {
+        char *end;
+        long a = strtol(p, &end, 10);
+        if (end == p) break;
+        long b = a;
+        if (*end == '-') b = strtol(end + 1, &end, 10);
+        for (long c = a; c <= b && c < CPU_SETSIZE; c++) CPU_SET((int)c, set);
+        p = (*end == ',') ? end + 1 : end;
+        if (*p == '\n') break;
+    }
+}
+
+// Finds NUMA nodes with CPUs from sysfs; a host without that information
+// counts as a single node holding every CPU
+static void discover_numa_nodes(void) {
+    numa_nodes = 0;
+    for (int n = 0; n < MAX_NUMA_NODES; n++) {
+        char path[96], line[4096];
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", n);
+        FILE *fp = fopen(path, "r");
+        if (!fp) continue;
+        if (fgets(line, sizeof(line), fp)) {
+            parse_cpulist(line, &numa_cpus[numa_nodes]);
+            if (CPU_COUNT(&numa_cpus[numa_nodes]) > 0) numa_nodes++;
+        }
+        fclose(fp);
+    }
+    if (numa_nodes == 0) {
+        sched_getaffinity(0, sizeof(cpu_set_t), &numa_cpus[0]);
+        numa_nodes = 1;
+    }
+}
+
+// Writes 'copies' placed copies of bytes at src into out: huge-page
+// backed when asked, and when replicating copy n is written while the
+// parent is pinned to node n, so first touch places the pages there.
+// Returns the number made (fewer on failure); *len_out is each mapping's
+// length.
+static int place_copies(const void *src, size_t bytes, int copies, char **out, size_t *len_out) {
+    size_t len = bytes;
+    if (opts.hugepages)
+        len = (len + HUGE_PAGE_SIZE - 1) & ~(size_t)(HUGE_PAGE_SIZE - 1);
+    *len_out = len;
+
+    cpu_set_t saved;
+    sched_getaffinity(0, sizeof(saved), &saved);
+    int made = 0;
+    for (int n = 0; n < copies; n++) {
+        if (opts.numa_replicate && sched_setaffinity(0, sizeof(cpu_set_t), &numa_cpus[n]) == -1)
+            perror("sched_setaffinity failed");
+        char *p = map_sequence_copy(len);
+        if (!p) break;
+        memcpy(p, src, bytes);
+        out[made++] = p;
+    }
+    sched_setaffinity(0, sizeof(saved), &saved);
+    return made;
+}
+
+// Replaces the heap sequence with placed copies: one, or one per NUMA
+// node when replicating
+static int place_sequence(void) {
+    int copies = 1;
+    if (opts.numa_replicate) {
+        discover_numa_nodes();
+        copies = numa_nodes;
+    }
+    seq_copy_count = place_copies(seq, seq_len + 1, copies, seq_copies, &seq_copy_len);
+    if (seq_copy_count < copies) return 1;
+
+    free(seq);
+    seq = seq_copies[0];
+    return 0;
+}
+
+// Child side of --numa-replicate: worker i runs on node i % nodes and
+// reads that node's replica
+static void bind_worker_node(int worker_id) {
+    int node = worker_id % seq_copy_count;
+    if (opts.numa_replicate &&
+        sched_setaffinity(0, sizeof(cpu_set_t), &numa_cpus[node]) == -1)
+        perror("sched_setaffinity failed");
+    seq = seq_copies[node];
+    if (packed_copy_count > 0) seq_packed = (uint64_t *)packed_copies[node];
+}
+
+// Creates the profile file at full size, maps it shared and fills in the
+// header; the counts are written by the workers
+static int open_profile(const char *fname) {
+    int fd = open(fname, O_CREAT | O_TRUNC | O_RDWR, 0666);
+    if (fd == -1) {
+        perror("open profile failed");
+        return 1;
+    }
+    size_t len = sizeof(profile_header_t) + seq_len * sizeof(uint16_t);
+    if (ftruncate(fd, (off_t)len) == -1) {
+        perror("ftruncate profile failed");
+        close(fd);
+        return 1;
+    }
+    void *map = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        perror("mmap profile failed");
+        return 1;
+    }
+    profile_map = map;
+    profile_map_len = len;
+
+    profile_header_t *hdr = (profile_header_t *)map;
+    memset(hdr, 0, sizeof(*hdr));
+    memcpy(hdr->magic, PROFILE_MAGIC, sizeof(hdr->magic));
+    hdr->version = PROFILE_VERSION;
+    hdr->header_size = sizeof(profile_header_t);
+    hdr->seq_len = seq_len;
+    hdr->subseq_len = subseq_len;
+    hdr->count = seq_len;
+    profile_counts = (uint16_t *)((char *)map + sizeof(profile_header_t));
+    return 0;
+}
+
+// Flushes and unmaps the profile file
+static int close_profile(void) {
+    int rc = 0;
+    if (msync(profile_map, profile_map_len, MS_SYNC) == -1) {
+        perror("msync profile failed");
+        rc = 1;
+    }
+    munmap(profile_map, profile_map_len);
+    profile_map = NULL;
+    profile_counts = NULL;
+    return rc;
+}
+
+// Adds one database file; skips anything that is not a regular file
+static int db_add_file(const char *path, int *cap) {
+    struct stat st;
+    if (stat(path, &st) == -1) {
+        perror(path);
+        return 1;
+    }
+    if (!S_ISREG(st.st_mode)) return 0;
+    if (db_file_count == *cap) {
+        int ncap = *cap ? 2 * *cap : 64;
+        char **np = (char **)realloc(db_paths, (size_t)ncap * sizeof(char *));
+        if (np) db_paths = np;
+        long long *ns = (long long *)realloc(db_sizes, (size_t)ncap * sizeof(long long));
+        if (ns) db_sizes = ns;
+        if (!np || !ns) {
+            perror("realloc failed");
+            return 1;
+        }
+        *cap = ncap;
+    }
+    db_paths[db_file_count] = strdup(path);
+    if (!db_paths[db_file_count]) {
+        perror("strdup failed");
+        return 1;
+    }
+    db_sizes[db_file_count++] = (long long)st.st_size;
+    return 0;
+}
+
+static int cmp_path(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+// Collects the files of a directory (sorted, hidden files and .fai
+// indexes skipped) or of a list file with one path per line
+static int db_collect_files(const char *db_path) {
+    struct stat st;
+    if (stat(db_path, &st) == -1) {
+        perror(db_path);
+        return 1;
+    }
+    int cap = 0;
+    char path[4096];
+    if (S_ISDIR(st.st_mode)) {
+        DIR *dir = opendir(db_path);
+        if (!dir) {
+            perror("opendir failed");
+            return 1;
+        }
+        struct dirent *de;
+        while ((de = readdir(dir)) != NULL) {
+            size_t n = strlen(de->d_name);
+            if (de->d_name[0] == '.' || (n > 4 && strcmp(de->d_name + n - 4, ".fai") == 0))
+                continue;
+            snprintf(path, sizeof(path), "%s/%s", db_path, de->d_name);
+            if (db_add_file(path, &cap) != 0) {
+                closedir(dir);
+                return 1;
+            }
+        }
+        closedir(dir);
+        if (db_file_count > 1)
+            qsort(db_paths, (size_t)db_file_count, sizeof(char *), cmp_path);
+        // Sizes were stored in readdir order; look them up again
+        for (int f = 0; f < db_file_count; f++) {
+            if (stat(db_paths[f], &st) == -1) {
+                perror(db_paths[f]);
+                return 1;
+            }
+            db_sizes[f] = (long long)st.st_size;
+        }
+    } else {
+        FILE *list = fopen(db_path, "r");
+        if (!list) {
+            perror("fopen failed");
+            return 1;
+        }
+        while (fgets(path, sizeof(path), list)) {
+            path[strcspn(path, "\r\n")] = '\0';
+            if (path[0] && db_add_file(path, &cap) != 0) {
+                fclose(list);
+                return 1;
+            }
+        }
+        fclose(list);
+    }
+    if (db_file_count == 0) {
+        fprintf(stderr, "no files to search in '%s'\n", db_path);
+        return 1;
+    }
+    return 0;
+}
+
+// First line start at or after nominal (nominal itself when no newline
+// follows within DB_SPLIT_WINDOW, e.g. inside one long sequence line)
+static long long db_split_point(int fd, long long nominal, long long size) {
+    char window[DB_SPLIT_WINDOW];
+    ssize_t got = pread(fd, window, sizeof(window), (off_t)(nominal - 1));
+    if (got <= 0) return nominal;
+    const char *nl = (const char *)memchr(window, '\n', (size_t)got);
+    if (!nl) return nominal;
+    long long split = nominal + (long long)(nl - window);
+    return split < size ? split : size;
+}
+
+// Splits every file into chunks (max_tasks is an upper bound); returns
+// the number of chunks or -1
+static int db_plan_tasks(int max_tasks) {
+    int n = 0;
+    for (int f = 0; f < db_file_count; f++) {
+        long long size = db_sizes[f];
+        int fd = size > (long long)DB_CHUNK_BYTES ? open(db_paths[f], O_RDONLY) : -1;
+        if (size > (long long)DB_CHUNK_BYTES && fd == -1) {
+            perror(db_paths[f]);
+            return -1;
+        }
+        long long start = 0;
+        do {
+            long long end = size;
+            if (fd != -1 && size - start > (long long)DB_CHUNK_BYTES)
+                end = db_split_point(fd, start + (long long)DB_CHUNK_BYTES, size);
+            if (n == max_tasks) break;
+            db_tasks[n].file = f;
+            db_tasks[n].start = start;
+            db_tasks[n].end = end;
+            db_tasks[n].last = end == size;
+            db_tasks[n].bases = 0;
+            n++;
+            start = end;
+        } while (start < size);
+        if (fd != -1) close(fd);
+    }
+    return n;
+}
+
+// Starts reading a chunk into the page cache so it loads while this
+// worker is busy with its current one
+static void db_prefetch(int t) {
+    if (t >= g_db->task_count) return;
+    int fd = open(db_paths[db_tasks[t].file], O_RDONLY);
+    if (fd == -1) return;
+    posix_fadvise(fd, (off_t)db_tasks[t].start,
+                  (off_t)(db_tasks[t].end - db_tasks[t].start), POSIX_FADV_WILLNEED);
+    close(fd);
+}
+
+// Filters chunk t (plus enough following bases to finish its last
+// alignments), scores its positions and merges the best into its file's hit
+static int db_search_task(int t, sem_t *lock, char **buf, size_t *cap) {
+    db_task_t *task = &db_tasks[t];
+    int fd = open(db_paths[task->file], O_RDONLY);
+    if (fd == -1) {
+        perror(db_paths[task->file]);
+        return 1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == -1) {
+        perror("fstat failed");
+        close(fd);
+        return 1;
+    }
+    size_t file_len = (size_t)st.st_size;
+    if (file_len == 0) {
+        close(fd);
+        task->done = 1;
+        return 0;
+    }
+    char *map = (char *)mmap(NULL, file_len, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        perror("mmap failed");
+        return 1;
+    }
+    size_t start = (size_t)task->start;
+    size_t end = (size_t)task->end < file_len ? (size_t)task->end : file_len;
+    madvise(map + (start & ~(size_t)4095), end - (start & ~(size_t)4095), MADV_SEQUENTIAL);
+
+    // Room for the chunk and one extension piece at a time
+    size_t need = end - start + DB_EXTEND_BYTES + 1;
+    if (need > *cap) {
+        char *nb = (char *)realloc(*buf, need);
+        if (!nb) {
+            perror("realloc failed");
+            munmap(map, file_len);
+            return 1;
+        }
+        *buf = nb;
+        *cap = need;
+    }
+    int fasta_state = DNA_FASTA_LINE_START;
+    size_t own = dna_filter_fasta(map + start, end - start, *buf, &fasta_state);
+    size_t have = own;
+    size_t next = end;
+    while (!task->last && next < file_len && have - own + 1 < subseq_len) {
+        size_t take = file_len - next < DB_EXTEND_BYTES ? file_len - next : DB_EXTEND_BYTES;
+        if (have + take + 1 > *cap) {
+            char *nb = (char *)realloc(*buf, *cap * 2 + take);
+            if (!nb) {
+                perror("realloc failed");
+                munmap(map, file_len);
+                return 1;
+            }
+            *buf = nb;
+            *cap = *cap * 2 + take;
+        }
+        have += dna_filter_fasta(map + next, take, *buf + have, &fasta_state);
+        next += take;
+    }
+    munmap(map, file_len);
+
+    // Score the chunk's own positions with the single-file kernels
+    seq = *buf;
+    seq_len = have;
+    int best_pos = -1;
+    int best_cnt = -1;
+    if (own > 0 && use_packed) {
+        free(seq_packed);
+        seq_packed = NULL;
+        if (setup_packed_kernel() != 0) return 1;
+        packed_best(0, own, &best_pos, &best_cnt);
+    } else if (own > 0 && use_tiled) {
+        tiled_best(0, own, &best_pos, &best_cnt);
+    } else {
+        for (size_t pos = 0; pos < own; pos++) {
+            int matches = count_matches(pos);
+            if (matches > best_cnt) {
+                best_cnt = matches;
+                best_pos = (int)pos;
+            }
+        }
+    }
+
+    // Chunks are in file order, so (task, offset) orders positions. The
+    // chunk is marked done under the lock so a checkpoint sees it whole.
+    if (sem_wait_retry(lock) != 0) return 1;
+    db_file_hit_t *hit = &db_hits[task->file];
+    if (best_pos >= 0 &&
+        (best_cnt > hit->best_count ||
+         (best_cnt == hit->best_count &&
+          (t < hit->best_task || (t == hit->best_task && best_pos < hit->best_offset))))) {
+        hit->best_count = best_cnt;
+        hit->best_task = t;
+        hit->best_offset = best_pos;
+    }
+    task->bases = (long long)own;
+    task->done = 1;
+    sem_post(lock);
+    return 0;
+}
+
+// Database worker: pulls chunks until the queue is empty
+static int db_worker(int worker_id, sem_t *lock) {
+    (void)worker_id;
+    char *buf = NULL;
+    size_t cap = 0;
+    int rc = 0;
+    for (;;) {
+        if (sem_wait_retry(lock) != 0) { rc = 1; break; }
+        int t = g_db->next_task;
+        if (t < g_db->task_count) g_db->next_task++;
+        sem_post(lock);
+        if (t >= g_db->task_count) break;
+        if (db_tasks[t].done) continue;   // restored from a checkpoint
+
+        // The other workers hold the next num_procs - 1 chunks; this
+        // one is likely to come back for the chunk after those
+        db_prefetch(t + num_procs);
+        if (db_search_task(t, lock, &buf, &cap) != 0) { rc = 1; break; }
+    }
+    free(buf);
+    seq = NULL;
+    return rc;
+}
+
+// Database mode: searches every file of db_path for the pattern
+static int search_database(const char *db_path, const char *subseq_file) {
+    ssize_t n_sub = dna_ingest_file(subseq_file, MAX_SUBSEQUENCE_SIZE, &subseq, NULL);
+    if (n_sub < 0) return 1;
+    subseq_len = (size_t)n_sub;
+    if (subseq_len == 0) {
+        fprintf(stderr, "empty subsequence\n");
+        cleanup_parent();
+        return 1;
+    }
+    int want_generic = opts.kernel && strcmp(opts.kernel, "generic") == 0;
+    if (opts.kernel && strcmp(opts.kernel, "packed") == 0 && subseq_len > PACKED_MAX_PATTERN) {
+        fprintf(stderr, "--kernel packed needs a pattern of at most %d bases\n",
+                PACKED_MAX_PATTERN);
+        cleanup_parent();
+        return 1;
+    }
+    use_packed = !want_generic && subseq_len <= PACKED_MAX_PATTERN &&
+                 !(opts.kernel && strcmp(opts.kernel, "tiled") == 0);
+    use_tiled = !want_generic && !use_packed;
+
+    if (db_collect_files(db_path) != 0) {
+        cleanup_parent();
+        return 1;
+    }
+
+    // Chunk count bound: split points only move forward
+    long long max_tasks = 0, total_bytes = 0;
+    for (int f = 0; f < db_file_count; f++) {
+        max_tasks += db_sizes[f] / (long long)DB_CHUNK_BYTES + 1;
+        total_bytes += db_sizes[f];
+    }
+    if (max_tasks > INT_MAX / 2) {
+        fprintf(stderr, "database too large\n");
+        cleanup_parent();
+        return 1;
+    }
+
+    // Queue, chunk table and hits in shared memory; the mapping is
+    // inherited by the workers
+    pid_t self = getpid();
+    snprintf(shm_name, sizeof(shm_name), "/dna_results_%ld", (long)self);
+    snprintf(sem_name, sizeof(sem_name), "/dna_lock_%ld", (long)self);
+    shm_fd = shm_open(shm_name, O_CREAT | O_EXCL | O_RDWR, 0666);
+    if (shm_fd == -1) {
+        perror("shm_open failed");
+        shm_name[0] = '\0';
+        cleanup_parent();
+        return 1;
+    }
+    shm_len = sizeof(db_queue_t) + (size_t)max_tasks * sizeof(db_task_t) +
+              (size_t)db_file_count * sizeof(db_file_hit_t);
+    if (ftruncate(shm_fd, (off_t)shm_len) == -1) {
+        perror("ftruncate failed");
+        cleanup_parent();
+        return 1;
+    }
+    g_db = (db_queue_t *)mmap(NULL, shm_len, PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0);
+    if (g_db == MAP_FAILED) {
+        perror("mmap failed");
+        g_db = NULL;
+        cleanup_parent();
+        return 1;
+    }
+    db_tasks = (db_task_t *)(g_db + 1);
+    db_hits = (db_file_hit_t *)(db_tasks + max_tasks);
+    int n_tasks = db_plan_tasks((int)max_tasks);
+    if (n_tasks < 0) {
+        cleanup_parent();
+        return 1;
+    }
+    g_db->next_task = 0;
+    g_db->task_count = n_tasks;
+    g_db->file_count = db_file_count;
+    for (int f = 0; f < db_file_count; f++) {
+        db_hits[f].best_count = -1;
+        db_hits[f].best_task = -1;
+        db_hits[f].best_offset = -1;
+    }
+    g_sem = sem_open(sem_name, O_CREAT | O_EXCL, 0666, 1);
+    if (g_sem == SEM_FAILED) {
+        perror("sem_open failed");
+        cleanup_parent();
+        return 1;
+    }
+    if (opts.checkpoint_file) {
+        child_pids = (pid_t *)calloc((size_t)num_procs, sizeof(pid_t));
+        if (!child_pids) {
+            perror("calloc failed");
+            cleanup_parent();
+            return 1;
+        }
+        ckpt_fp = ckpt_fingerprint();
+        if (opts.resume && load_checkpoint() != 0) {
+            cleanup_parent();
+            return 1;
+        }
+        // The scan rate covers only the chunks this run reads
+        for (int t = 0; t < n_tasks; t++)
+            if (db_tasks[t].done) total_bytes -= db_tasks[t].end - db_tasks[t].start;
+        block_child_signals();
+    }
+
+    // Warm the first chunk of each worker before forking
+    for (int t = 0; t < num_procs && t < n_tasks; t++) db_prefetch(t);
+
+    int started = 0;
+    int failed = 0;
+    double t_start = now_ms();
+    for (int i = 0; i < num_procs; i++) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            if (opts.checkpoint_file) sigprocmask(SIG_SETMASK, &ckpt_saved_mask, NULL);
+            _exit(db_worker(i, g_sem));
+        } else if (pid > 0) {
+            if (child_pids) child_pids[started] = pid;
+            started++;
+        } else {
+            perror("fork failed");
+            failed = 1;
+            break;
+        }
+    }
+    int interrupted = 0;
+    if (opts.checkpoint_file) {
+        if (!failed && wait_with_checkpoints(started, &interrupted) != 0) failed = 1;
+        started = 0;
+    }
+    for (int i = 0; i < started; i++) {
+        int wstatus = 0;
+        if (wait(&wstatus) == -1) {
+            perror("wait failed");
+            failed = 1;
+            break;
+        }
+        if (!WIFEXITED(wstatus) || WEXITSTATUS(wstatus) != 0) failed = 1;
+    }
+    if (interrupted) {
+        fprintf(stderr, "interrupted; progress saved to %s\n", opts.checkpoint_file);
+        cleanup_parent();
+        return 1;
+    }
+    if (failed) {
+        fprintf(stderr, "child process error\n");
+        cleanup_parent();
+        return 1;
+    }
+    double t_search = now_ms() - t_start;
+
+    // Turn chunk offsets into file positions; the overall best prefers
+    // the higher count, then the earlier file
+    long long *file_pos = (long long *)malloc((size_t)db_file_count * sizeof(long long));
+    if (!file_pos) {
+        perror("malloc failed");
+        cleanup_parent();
+        return 1;
+    }
+    long long before = 0;
+    for (int t = 0; t < n_tasks; t++) {
+        int f = db_tasks[t].file;
+        if (t == 0 || db_tasks[t - 1].file != f) before = 0;
+        if (db_hits[f].best_task == t) file_pos[f] = before + db_hits[f].best_offset;
+        before += db_tasks[t].bases;
+    }
+    int best_file = -1;
+    for (int f = 0; f < db_file_count; f++) {
+        if (db_hits[f].best_task < 0) file_pos[f] = -1;
+        else if (best_file < 0 || db_hits[f].best_count > db_hits[best_file].best_count)
+            best_file = f;
+    }
+
+    printf("Number of Processes: %d\n", num_procs);
+    printf("Best Match Position: %lld\n", best_file >= 0 ? file_pos[best_file] : -1LL);
+    printf("Best Match Count:    %d\n", best_file >= 0 ? db_hits[best_file].best_count : -1);
+    printf("Best Match File:     %s\n", best_file >= 0 ? db_paths[best_file] : "(none)");
+    printf("Files Searched:      %d (%d chunks)\n", db_file_count, n_tasks);
+    printf("Scan Rate:           %.3f GB/s (%lld bytes in %.3f ms)\n",
+           t_search > 0.0 ? (double)total_bytes / (t_search * 1e6) : 0.0, total_bytes, t_search);
+    if (opts.checkpoint_file) {
+        printf("Checkpoints Written: %d (%.3f ms, %.3f%% of search time)%s\n", ckpt_writes,
+               ckpt_write_ms, t_search > 0.0 ? 100.0 * ckpt_write_ms / t_search : 0.0,
+               ckpt_resumed ? ", resumed" : "");
+        unlink(opts.checkpoint_file);
+    }
+    printf("Per-File Best:       position count file\n");
+    for (int f = 0; f < db_file_count; f++)
+        printf("%12lld %6d  %s\n", file_pos[f], db_hits[f].best_count, db_paths[f]);
+
+    free(file_pos);
+    cleanup_parent();
+    return 0;
+}
+
+// Base compares the selected search will make (a rough cost for sizing)
+static long long estimate_work(void) {
+    if (opts.query) return (long long)n_candidates * (long long)subseq_len;
+    if (opts.edit) return (long long)seq_len * (long long)edit_blocks * 64;
+    long long work = full_compare_count();
+    return opts.both_strands ? 2 * work : work;
+}
+
+// Settles num_procs and the backend. Explicit choices are kept; "auto"
+// sizes by work per worker and prints what it picked and why.
+static int choose_backend(void) {
+    int want_thread = opts.backend && strcmp(opts.backend, "thread") == 0;
+    int want_process = opts.backend && strcmp(opts.backend, "process") == 0;
+    int auto_backend = opts.backend && strcmp(opts.backend, "auto") == 0;
+
+    // Replicas are selected by rewriting the global seq in each worker.
+    // The deadline raises a cancel flag the workers poll, but its wait
+    // loop reaps them by pid; checkpoints kill them by pid on SIGTERM.
+    if (want_thread && (opts.numa_replicate || opts.deadline_ms > 0.0 || opts.checkpoint_file)) {
+        fprintf(stderr, "--backend thread cannot be combined with --numa-replicate, "
+                        "--deadline or --checkpoint\n");
+        return 1;
+    }
+    if (!opts.auto_procs && !auto_backend) {
+        backend = want_thread ? BACKEND_THREAD : BACKEND_PROCESS;
+        return 0;
+    }
+
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    if (online < 1) online = 1;
+    long long work = estimate_work();
+    if (opts.auto_procs) {
+        long long by_work = work / AUTO_WORK_PER_WORKER;
+        num_procs = by_work < online ? (int)(by_work > 1 ? by_work : 1) : (int)online;
+    }
+    long long per_worker = work / num_procs;
+
+    char reason[160];
+    int need_process = opts.numa_replicate || opts.deadline_ms > 0.0 || opts.checkpoint_file;
+    if (num_procs == 1 && !want_process && !need_process) {
+        backend = BACKEND_INLINE;
+        if (online == 1)
+            snprintf(reason, sizeof(reason), "1 CPU online");
+        else
+            snprintf(reason, sizeof(reason), "%lld compares is under %lld per extra worker",
+                     work, AUTO_WORK_PER_WORKER);
+    } else if (want_process || need_process) {
+        backend = BACKEND_PROCESS;
+        snprintf(reason, sizeof(reason), "%s", want_process ? "--backend process"
+                                         : opts.numa_replicate ? "--numa-replicate needs processes"
+                                         : opts.deadline_ms > 0.0 ? "--deadline needs processes"
+                                                                  : "--checkpoint needs processes");
+    } else if (want_thread || per_worker < AUTO_PROCESS_WORK) {
+        backend = BACKEND_THREAD;
+        snprintf(reason, sizeof(reason), "%lld compares per worker, fork would not amortize",
+                 per_worker);
+    } else {
+        backend = BACKEND_PROCESS;
+        snprintf(reason, sizeof(reason), "%lld compares per worker amortizes fork", per_worker);
+    }
+    fprintf(stderr, "auto: %d %s, %ld CPU(s) online, %lld compares (%s)\n", num_procs,
+            backend == BACKEND_INLINE ? "worker in-process"
+            : backend == BACKEND_THREAD ? "threads" : "processes",
+            online, work, reason);
+    return 0;
+}
+
+// Thread body: worker id in, status out
+static void *thread_worker(void *arg) {
+    int id = (int)(intptr_t)arg;
+    int rc = opts.instrument ? run_worker_instrumented(id, g_results, g_sem)
+                             : run_worker(id, g_results, g_sem);
+    return (void *)(intptr_t)rc;
+}
+
+// Runs the workers as threads of this process (or inline for one)
+static int run_threads(void) {
+    if (backend == BACKEND_INLINE)
+        return thread_worker((void *)(intptr_t)0) != NULL;
+
+    pthread_t *threads = (pthread_t *)malloc((size_t)num_procs * sizeof(pthread_t));
+    if (!threads) {
+        perror("malloc failed");
+        return 1;
+    }
+    int started = 0;
+    int failed = 0;
+    for (; started < num_procs; started++) {
+        int err = pthread_create(&threads[started], NULL, thread_worker,
+                                 (void *)(intptr_t)started);
+        if (err != 0) {
+            errno = err;
+            perror("pthread_create failed");
+            failed = 1;
+            break;
+        }
+    }
+    for (int i = 0; i < started; i++) {
+        void *ret = NULL;
+        pthread_join(threads[i], &ret);
+        if (ret != NULL) failed = 1;
+    }
+    free(threads);
+    if (failed) fprintf(stderr, "worker thread error\n");
+    return failed;
+}
+
+// Monotonic clock in milliseconds
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1e6;
+}
+
+// Cleans up shared memory, semaphores, and allocated memory
+static void cleanup_parent(void) {
+    if (index_map) {
+        munmap(index_map, index_map_len);
+        index_map = NULL;
+        seq = NULL;
+    }
+    if (candidates) { free(candidates); candidates = NULL; }
+    if (seq_records.recs) {
+        free(seq_records.recs);
+        seq_records.recs = NULL;
+        seq_records.count = 0;
+    }
+    if (edit_peq)   { free(edit_peq);   edit_peq = NULL; }
+    if (profile_map) {
+        munmap(profile_map, profile_map_len);
+        profile_map = NULL;
+        profile_counts = NULL;
+    }
+    if (seq_copy_count > 0) {
+        for (int n = 0; n < seq_copy_count; n++)
+            munmap(seq_copies[n], seq_copy_len);
+        seq_copy_count = 0;
+        seq = NULL;
+    }
+    if (seq)      { free(seq);    seq = NULL; }
+    if (subseq)   { free(subseq); subseq = NULL; }
+    if (subseq_rc) { free(subseq_rc); subseq_rc = NULL; }
+    if (subseq_code) { free(subseq_code); subseq_code = NULL; }
+    if (child_pids) { free(child_pids); child_pids = NULL; }
+    free(qg_keys);    qg_keys = NULL;
+    free(qg_start);   qg_start = NULL;
+    free(qg_count);   qg_count = NULL;
+    free(qg_offsets); qg_offsets = NULL;
+    if (packed_copy_count > 0) {
+        for (int n = 0; n < packed_copy_count; n++)
+            munmap(packed_copies[n], packed_copy_len);
+        packed_copy_count = 0;
+        seq_packed = NULL;
+    }
+    if (seq_packed) { free(seq_packed); seq_packed = NULL; }
+    if (db_paths) {
+        for (int f = 0; f < db_file_count; f++) free(db_paths[f]);
+        free(db_paths);
+        db_paths = NULL;
+        db_file_count = 0;
+    }
+    if (db_sizes) { free(db_sizes); db_sizes = NULL; }
+    if (g_db) {
+        munmap(g_db, shm_len);
+        g_db = NULL;
+        db_tasks = NULL;
+        db_hits = NULL;
+    }
+    if (g_job) {
+        munmap(g_job, shm_len);
+        g_job = NULL;
+        g_results = NULL;
+    }
+    if (g_results && g_results != MAP_FAILED) {
+        munmap(g_results, shm_len);
+        g_results = NULL;
+    }
+    if (shm_fd != -1) {
+        close(shm_fd);
+        shm_fd = -1;
     }
     if (shm_name[0]) {
         shm_unlink(shm_name);
@@ -362,6 +3974,22 @@ static void cleanup_parent(void) {
         sem_unlink(sem_name);
         sem_name[0] = '\0';
     }
+    if (g_start_sem && g_start_sem != SEM_FAILED) {
+        sem_close(g_start_sem);
+        g_start_sem = NULL;
+    }
+    if (start_sem_name[0]) {
+        sem_unlink(start_sem_name);
+        start_sem_name[0] = '\0';
+    }
+    if (g_done_sem && g_done_sem != SEM_FAILED) {
+        sem_close(g_done_sem);
+        g_done_sem = NULL;
+    }
+    if (done_sem_name[0]) {
+        sem_unlink(done_sem_name);
+        done_sem_name[0] = '\0';
+    }
 }
 
 // No cleanup needed in child (resources are parent-owned)
@@ -373,9 +4001,30 @@ static void cleanup_child(void) {
 
 // Prints usage instructions
 static void usage(const char *prog) {
-    fprintf(stdout, "Usage: %s <seq_file> <subseq_file> <num_procs>\n", prog);
+    fprintf(stdout, "Usage: %s [options] <seq_file> <subseq_file> <num_procs>\n", prog);
+    fprintf(stdout, "       %s --build-index <seq_file> <index_file>\n", prog);
+    fprintf(stdout, "       %s --query <index_file> <subseq_file> <num_procs>\n", prog);
+    fprintf(stdout, "       %s --fasta-index <fasta_file>\n", prog);
+    fprintf(stdout, "       %s --serve <seq_file> <socket_path> <num_procs>\n", prog);
+    fprintf(stdout, "       %s --client <socket_path> <subseq_file> <iterations>\n", prog);
+    fprintf(stdout, "       %s --db <directory|file_list> <subseq_file> <num_procs>\n", prog);
     fprintf(stdout, "seq_file: main DNA sequence (max 1MB)\n");
     fprintf(stdout, "subseq_file: DNA to search for (max 10KB)\n");
-    fprintf(stdout, "num_procs: number of processes\n");
+    fprintf(stdout, "num_procs: number of processes, or 'auto'\n");
+    fprintf(stdout, "--backend auto|process|thread: how the workers run\n");
+    fprintf(stdout, "--early-abandon: skip alignments that cannot beat the best so far\n");
+    fprintf(stdout, "--build-index/--query: seed-and-extend search against a k-mer index\n");
+    fprintf(stdout, "--edit: best end position under edit distance; --time: print search time\n");
+    fprintf(stdout, "--profile FILE: write every position's match count to FILE\n");
+    fprintf(stdout, "--contig NAME: search one record of an indexed FASTA file\n");
+    fprintf(stdout, "--iupac: keep ambiguity codes and match overlapping base sets\n");
+    fprintf(stdout, "--both-strands: also score the reverse complement in the same pass\n");
+    fprintf(stdout, "--instrument: print per-worker timing, waits and page faults\n");
+    fprintf(stdout, "--hugepages thp|explicit, --numa-replicate: sequence page placement\n");
+    fprintf(stdout, "--matrix FILE: rank by substitution-matrix score (4x4, or 16x16 with --iupac)\n");
+    fprintf(stdout, "--deadline MS: coarse-to-fine scan, best-so-far result when time runs out\n");
+    fprintf(stdout, "--checkpoint FILE [--checkpoint-interval MS] [--resume]: save/continue progress\n");
+    fprintf(stdout, "--filter PCT: q-gram filter, score only windows that can reach PCT%% identity\n");
+    fprintf(stdout, "--kernel auto|generic|packed|tiled: Hamming kernel (packed: patterns <= 64)\n");
     fprintf(stdout, "Example: %s sequence.txt subsequence.txt 4\n", prog);
 }
@@ -6,13 +6,18 @@ Brief: Finds the best matching position of a DNA subsequence within a larger DNA
 Each process searches every P-th index of the sequence, based on its process ID, and reports its best local match. 
 Shared results are stored in POSIX shared memory and synchronized using a named semaphore to prevent data conflicts. 
 The program outputs three lines showing the total number of processes, the best match position, and the match count.
-Compile by: gcc -Wall prog2.c -o prog2 -lpthread
+Input files are read through dna_ingest, so only A/C/G/T count (lowercase is uppercased, newlines are dropped).
+Num Processes may be "auto": the count then follows the online CPUs and the input size, small inputs run in this
+process alone, and mid-sized ones use threads instead of fork. The choice and its reason go to stderr.
+Compile by: gcc -Wall prog2a.c dna_ingest.c -o prog2a -lpthread
 Compiler: gcc
 ***********************************************************************/
 
 #include <errno.h>
 #include <fcntl.h>
+#include <pthread.h>
 #include <semaphore.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -22,10 +27,17 @@ Compiler: gcc
 #include <sys/wait.h>
 #include <unistd.h>
 
+#include "dna_ingest.h"
+
 // Max sizes for sequence.txt, subsequence.txt and number of processes
 #define MAX_SEQUENCE_SIZE       1048576  // 1MB
 #define MAX_SUBSEQUENCE_SIZE     10240   // 10KB
-#define MAX_PROCS                  20    // 20 processes max
+#define MAX_PROCS                  20    // 20 processes max (explicit counts)
+
+// Auto mode: base compares each worker should get before another one is
+// worth starting, and per-worker compares above which fork is amortized
+#define AUTO_WORK_PER_WORKER   (4LL * 1000 * 1000)
+#define AUTO_PROCESS_WORK      (256LL * 1000 * 1000)
 
 // Only two items live in shared memory
 typedef struct {
@@ -48,8 +60,15 @@ static shared_results_t *sharedBest = NULL;
 static char sem_name[64];
 static sem_t *semLock = NULL;
 
+// worker backend picked by auto mode (0 = fork, the default)
+static int useThreads = 0;
+
 // fwd decl
 static void usage(const char *prog);
+static void searchStride(int procIndex, int *bestPos, int *bestCnt);
+static int publishBest(int bestPos, int bestCnt);
+static void *threadMain(void *arg);
+static void chooseAuto(void);
 
 // Main
 int main(int argc, char *argv[]) {
@@ -60,8 +79,9 @@ int main(int argc, char *argv[]) {
         return 1;
     }
 
-    // Parse number of processes and bound to MAX_PROCS
-    num_procs = atoi(argv[3]);
+    // Parse number of processes and bound to MAX_PROCS ("auto" is sized later)
+    int autoProcs = strcmp(argv[3], "auto") == 0;
+    num_procs = autoProcs ? 1 : atoi(argv[3]);
     if (num_procs <= 0) {
         fprintf(stderr, "need positive number of processes\n");
         return 1;
@@ -71,23 +91,15 @@ int main(int argc, char *argv[]) {
         num_procs = MAX_PROCS;
     }
 
-    // Read sequence file into memory
-    FILE *fp = fopen(argv[1], "rb");
-    if (!fp) { perror("fopen sequence"); return 1; }
-    sequence = (char*)malloc(MAX_SEQUENCE_SIZE + 1);
-    if (!sequence) { perror("malloc sequence"); fclose(fp); return 1; }
-    sequenceLen = fread(sequence, 1, MAX_SEQUENCE_SIZE, fp);
-    fclose(fp);
-    sequence[sequenceLen] = '\0';  // ensure string termination
+    // Read sequence file into memory (A/C/G/T only, NUL-terminated)
+    ssize_t n = dna_ingest_file(argv[1], MAX_SEQUENCE_SIZE, &sequence, NULL);
+    if (n < 0) return 1;
+    sequenceLen = (size_t)n;
 
     // Read subsequence file into memory
-    fp = fopen(argv[2], "rb");
-    if (!fp) { perror("fopen subsequence"); free(sequence); return 1; }
-    target = (char*)malloc(MAX_SUBSEQUENCE_SIZE + 1);
-    if (!target) { perror("malloc subsequence"); fclose(fp); free(sequence); return 1; }
-    targetLen = fread(target, 1, MAX_SUBSEQUENCE_SIZE, fp);
-    fclose(fp);
-    target[targetLen] = '\0';  // ensure string termination
+    n = dna_ingest_file(argv[2], MAX_SUBSEQUENCE_SIZE, &target, NULL);
+    if (n < 0) { free(sequence); return 1; }
+    targetLen = (size_t)n;
 
     // Validate non-empty input files
     if (sequenceLen == 0 || targetLen == 0) {
@@ -96,6 +108,9 @@ int main(int argc, char *argv[]) {
         return 1;
     }
 
+    // Auto mode: worker count and backend from the CPUs and input size
+    if (autoProcs) chooseAuto();
+
     // Create unique names for kernel objects (based on PID)
     pid_t mainPid = getpid();
     snprintf(shm_name, sizeof(shm_name), "/dna_results_%ld", (long)mainPid);
@@ -123,39 +138,45 @@ int main(int argc, char *argv[]) {
     semLock = sem_open(sem_name, O_CREAT | O_EXCL, S_IRUSR | S_IWUSR, 1);
     if (semLock == SEM_FAILED) { perror("sem_open"); return 1; }
 
+    // Threads share this process: worker i still takes positions i, i+P, ...
+    if (useThreads) {
+        pthread_t threads[MAX_PROCS];
+        pthread_t *tids = num_procs <= MAX_PROCS ? threads
+                        : (pthread_t *)malloc((size_t)num_procs * sizeof(pthread_t));
+        if (!tids) { perror("malloc"); return 1; }
+        int created = 0, failed = 0;
+        for (; created < num_procs; created++) {
+            if (pthread_create(&tids[created], NULL, threadMain, (void *)(intptr_t)created) != 0) {
+                perror("pthread_create");
+                failed = 1;
+                break;
+            }
+        }
+        for (int i = 0; i < created; i++) {
+            void *ret = NULL;
+            pthread_join(tids[i], &ret);
+            if (ret != NULL) failed = 1;
+        }
+        if (tids != threads) free(tids);
+        if (failed) return 1;
+    }
+
     // Fork workers: child i processes positions i, i+P, i+2P, ...
+    // (when auto picked one worker, it runs right here, without fork)
     int started = 0;
-    for (int i = 0; i < num_procs; i++) {
+    int inlineRun = autoProcs && num_procs == 1;
+    if (inlineRun) {
+        int localBestPos, localBestCnt;
+        searchStride(0, &localBestPos, &localBestCnt);
+        if (publishBest(localBestPos, localBestCnt) != 0) return 1;
+    }
+    for (int i = 0; i < num_procs && !useThreads && !inlineRun; i++) {
         pid_t pid = fork();
         if (pid == 0) {
             // Child: compute best local match over its interleaved positions
-            const int procIndex = i;
-            int localBestPos = -1;
-            int localBestCnt = -1;
-
-            for (size_t pos = (size_t)procIndex; pos < sequenceLen; pos += (size_t)num_procs) {
-                int matches = 0;
-                for (size_t j = 0; j < targetLen; j++) {
-                    size_t sidx = pos + j;
-                    if (sidx >= sequenceLen) break;
-                    if (sequence[sidx] == target[j]) matches++;
-                }
-                if (matches > localBestCnt) {
-                    localBestCnt = matches;
-                    localBestPos = (int)pos;
-                }
-            }
-
-            if (localBestCnt >= 0) {
-                if (sem_wait(semLock) == -1) { perror("sem_wait"); _exit(1); }
-                if (localBestCnt > sharedBest->best_count ||
-                   (localBestCnt == sharedBest->best_count && localBestPos < sharedBest->best_position)) {
-                    sharedBest->best_count    = localBestCnt;
-                    sharedBest->best_position = localBestPos;
-                }
-                if (sem_post(semLock) == -1) { perror("sem_post"); _exit(1); }
-            }
-            _exit(0);  // child done, exit
+            int localBestPos, localBestCnt;
+            searchStride(i, &localBestPos, &localBestCnt);
+            _exit(publishBest(localBestPos, localBestCnt));  // child done, exit
         } else if (pid > 0) {
             started++;
         } else {
@@ -181,8 +202,68 @@ int main(int argc, char *argv[]) {
     return 0;
 }
 
+// Best match over positions procIndex, procIndex+P, ...
+static void searchStride(int procIndex, int *bestPos, int *bestCnt) {
+    int localBestPos = -1;
+    int localBestCnt = -1;
+    for (size_t pos = (size_t)procIndex; pos < sequenceLen; pos += (size_t)num_procs) {
+        int matches = 0;
+        for (size_t j = 0; j < targetLen; j++) {
+            size_t sidx = pos + j;
+            if (sidx >= sequenceLen) break;
+            if (sequence[sidx] == target[j]) matches++;
+        }
+        if (matches > localBestCnt) {
+            localBestCnt = matches;
+            localBestPos = (int)pos;
+        }
+    }
+    *bestPos = localBestPos;
+    *bestCnt = localBestCnt;
+}
+
+// Merges a local best into shared memory under the semaphore
+static int publishBest(int bestPos, int bestCnt) {
+    if (bestCnt < 0) return 0;
+    if (sem_wait(semLock) == -1) { perror("sem_wait"); return 1; }
+    if (bestCnt > sharedBest->best_count ||
+       (bestCnt == sharedBest->best_count && bestPos < sharedBest->best_position)) {
+        sharedBest->best_count    = bestCnt;
+        sharedBest->best_position = bestPos;
+    }
+    if (sem_post(semLock) == -1) { perror("sem_post"); return 1; }
+    return 0;
+}
+
+// Thread backend entry: same work as a forked child
+static void *threadMain(void *arg) {
+    int localBestPos, localBestCnt;
+    searchStride((int)(intptr_t)arg, &localBestPos, &localBestCnt);
+    return (void *)(intptr_t)publishBest(localBestPos, localBestCnt);
+}
+
+// Picks the worker count (online CPUs, at most one per AUTO_WORK_PER_WORKER
+// compares) and fork vs threads, and says why on stderr
+static void chooseAuto(void) {
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    if (online < 1) online = 1;
+    long long work = (long long)sequenceLen * (long long)targetLen;
+    long long byWork = work / AUTO_WORK_PER_WORKER;
+    num_procs = byWork < online ? (int)(byWork > 1 ? byWork : 1) : (int)online;
+    long long perWorker = work / num_procs;
+    useThreads = num_procs > 1 && perWorker < AUTO_PROCESS_WORK;
+
+    const char *how = num_procs == 1 ? "single-threaded" : useThreads ? "threads" : "processes";
+    const char *why = num_procs == 1
+        ? (online == 1 ? "1 CPU online" : "too little work to split")
+        : useThreads ? "fork would not amortize" : "enough work per worker to amortize fork";
+    fprintf(stderr, "auto: %d worker(s), %s; %ld CPU(s), ~%lld compares (%s)\n",
+            num_procs, how, online, work, why);
+}
+
 // Usage message
 static void usage(const char *prog) {
     fprintf(stdout, "Usage: %s <Sequence File Name> <Subsequence File Name> <Num Processes>\n", prog);
+    fprintf(stdout, "Num Processes may be 'auto' (picks the count and fork vs threads)\n");
     fprintf(stdout, "Example: %s sequence.txt subsequence.txt 4\n", prog);
 }
@@ -4,42 +4,305 @@ Author: Sean Anderson
 Date: November 10, 2025
 Brief: Simulates virtual memory behavior using a local LRU policy
        Each process has a fixed number of frames and its own LRU list
-       Input lines are "<proc> <page>" where proc is 1-4
-       The program prints hit rates for P1–P4 and the overall average
+       Input lines are "<pid> <page>" with 64-bit PIDs and page numbers
+       The program prints hit rates for P1–P4 (PIDs 1-4; other PIDs
+       get no frames) and the overall average
+       Each LRU is a page->node hash over a pooled, index-linked list,
+       so a reference costs O(1) whatever the frame count
+       vvm_sim --bench <datafile> [min_refs] replays the trace against
+       the original array LRU and the hashed one for a range of frame
+       counts and prints references per second for each
+       vvm_sim --curve <datafile> [max_frames] reads the trace once and
+       prints every process's LRU hit rate for each frame count from 0
+       to max_frames (default: the most distinct pages of any process),
+       from Mattson stack distances kept with a Fenwick tree over
+       last-access times; any allocation can be read off the table
+       vvm_sim --allocate <datafile> <frames> [refs | w1 w2 w3 w4]
+       splits a frame budget across the processes to maximize the
+       mean hit rate (or a weighted mean; 'refs' weights by reference
+       count, i.e. the overall hit rate) from the same curves, by an
+       exact DP at 1-frame granularity, and prints the best split for
+       every budget up to <frames>
+       vvm_sim --policy <name|all> <datafile> <p1> <p2> <p3> <p4> runs
+       the same simulation under another replacement policy (lru, fifo,
+       clock, clockpro, lfu, arc, 2q, or Belady's opt from a precomputed
+       next-use array), or all of them, and adds references per second
+       vvm_sim --procs <datafile> <frames|config> [policy] simulates
+       every PID in the trace: a process is created on its first
+       reference in a PID hash, with the frames its config line gives
+       ("<pid> <frames>", plus "default <frames>" for unlisted PIDs) or
+       the given count, so memory follows frames, not the PID range
 
 Compile by: gcc -Wall prog3.c -o vvm_sim
 Compiler: gcc
 ***********************************************************************/
 
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #define MAX_LINE 128
 #define PROCS     4
+#define BENCH_MIN_REFS 1000000L
+#define ALLOC_DP_MAX   8192   // larger budgets use greedy over concave hulls
 
 
+// page numbers are 64-bit; traces may use sparse or huge page IDs
+typedef long long page_t;
+
 // each process uses a simple LRU cache
 typedef struct {
-    int *q;
+    page_t *q;
     int size;
     int cap;
 } lru_t;
 
+// O(1) LRU: nodes live in one pooled array linked by index from most
+// (head) to least (tail) recently used; an open-addressing table with
+// linear probing maps a page to its node (-1 marks an empty slot)
+typedef struct {
+    page_t page;
+    int prev;
+    int next;
+} lru_node_t;
+
+typedef struct {
+    lru_node_t *nodes;
+    int *table;
+    unsigned mask;
+    int head;
+    int tail;
+    int size;
+    int cap;
+    int fresh;        // nodes handed out so far
+    int free_head;    // evicted nodes, chained through next
+} hlru_t;
+
+// a replacement policy for one process's frames, driven by policy_ref:
+// init(frames) returns its state (NULL if out of memory); access returns
+// 1 on a hit, or 0 on a miss without loading the page (it may note the
+// miss, e.g. a ghost hit); after a miss, evict drops exactly one resident
+// page and returns it if every frame is in use, then insert loads the
+// page. next_use is the trace index of the page's next reference
+// (LONG_MAX if none); only OPT looks at it.
+typedef struct {
+    const char *name;
+    void *(*init)(int frames);
+    int (*access)(void *st, page_t page, long next_use);
+    page_t (*evict)(void *st);
+    void (*insert)(void *st, page_t page, long next_use);
+    void (*destroy)(void *st);
+} policy_t;
+
+// fixed-size page -> int map shared by the policies (open addressing,
+// a negative value marks an empty slot)
+typedef struct {
+    page_t *keys;
+    int *vals;
+    unsigned mask;
+} imap_t;
+
+// list node and pooled list of the policies, linked by index like
+// lru_node_t; tag records which list or bucket holds the node
+typedef struct {
+    page_t page;
+    int prev;
+    int next;
+    int tag;
+    int ref;
+} pnode_t;
+
+typedef struct {
+    int head;
+    int tail;
+    int size;
+} plist_t;
+
+typedef struct {
+    pnode_t *nodes;
+    int free_head;
+    int fresh;
+} pool_t;
+
+typedef struct {
+    page_t *ring;
+    int head;
+    int size;
+    int cap;
+    imap_t map;       // page -> 0 while resident
+} fifo_t;
+
+typedef struct {
+    page_t *pages;
+    unsigned char *ref;
+    int hand;
+    int size;
+    int cap;
+    int spare;        // frame freed by the last eviction
+    imap_t map;       // page -> frame
+} clk_t;
+
+// CLOCK-Pro: resident hot and cold pages plus non-resident test pages
+// on one ring swept by three hands
+enum { CP_HOT, CP_COLD, CP_TEST };
+
+typedef struct {
+    pool_t pool;
+    imap_t map;       // page -> node, resident or test
+    int hand_hot;
+    int hand_cold;
+    int hand_test;
+    int count_hot;
+    int count_cold;
+    int count_test;
+    int mem_cold;     // adaptive target for resident cold pages
+    int cap;
+    int owed;         // evictions hand_cold still has to make
+    int pending;      // test page that just faulted, -1 if none
+    page_t victim;
+} cpro_t;
+
+typedef struct {
+    long freq;
+    plist_t pages;
+    int prev;
+    int next;
+} lfu_bucket_t;
+
+typedef struct {
+    pool_t pool;
+    imap_t map;       // page -> node
+    lfu_bucket_t *buckets;
+    int bfirst;       // lowest frequency in use
+    int bfree;
+    int size;
+    int cap;
+} lfu_t;
+
+// ARC: resident T1 (seen once) and T2 (seen again) with ghost lists B1, B2
+enum { ARC_T1, ARC_T2, ARC_B1, ARC_B2 };
+
+typedef struct {
+    pool_t pool;
+    imap_t map;       // page -> node, resident or ghost
+    plist_t lists[4];
+    int p;            // target size of T1
+    int cap;
+    int pending;      // ghost node that just faulted, -1 for a new page
+} arc_t;
+
+// 2Q: resident Am and A1in, ghost A1out
+enum { Q_AM, Q_A1IN, Q_A1OUT };
+
+typedef struct {
+    pool_t pool;
+    imap_t map;       // page -> node, resident or ghost
+    plist_t lists[3];
+    int kin;
+    int kout;
+    int cap;
+    int pending;      // A1out node that just faulted, -1 for a new page
+} twoq_t;
+
+// OPT: frames in a max-heap on next use
+typedef struct {
+    page_t *page;
+    long *key;
+    int *heap;
+    int *pos;         // frame -> heap index
+    int size;
+    int cap;
+    int spare;        // frame freed by the last eviction
+    imap_t map;       // page -> frame
+} opt_t;
+
+// one edge of a process's concave hull: len frames at a gain of slope each
+typedef struct {
+    int proc;
+    int len;
+    double slope;
+} hull_edge_t;
+
+// growable page -> value map for the stack-distance pass (open
+// addressing; a negative value marks an empty slot)
+typedef struct {
+    page_t *keys;
+    long *vals;
+    unsigned mask;
+    int count;
+} pmap_t;
+
+// one process in the stack-distance pass, sized by its distinct pages,
+// not its references: access times run 1..cap on a Fenwick tree, at[t]
+// is the page accessed at time t, and when the clock reaches cap the
+// live times are renumbered 1..distinct in order
+typedef struct {
+    pmap_t last;      // page -> time of its latest access
+    int *tree;
+    page_t *at;
+    long cap;
+    long now;
+    long refs;
+    long *hist;       // hist[d]: references at stack distance d
+    long hist_cap;
+} sdist_t;
+
+// one process, created on its PID's first reference; beyond this record
+// it only holds its policy's state, which is sized by its frames (none
+// for a process with 0 frames)
+typedef struct {
+    long long pid;
+    int frames;
+    long refs;
+    long hits;
+    int resident;
+    void *st;
+} proc_t;
+
+// PID -> process hash: open addressing over indices into procs (-1
+// marks an empty slot), so memory follows the PIDs seen, not their range
+typedef struct {
+    proc_t *procs;
+    int *table;
+    unsigned mask;
+    int count;
+    int cap;
+} ptable_t;
+
+// frame allocation: explicit PIDs sorted for binary search, and a
+// default for every other PID
+typedef struct {
+    long long pid;
+    int frames;
+} alloc_entry_t;
+
+typedef struct {
+    alloc_entry_t *entries;
+    int count;
+    int dflt;
+} alloc_cfg_t;
+
 // print error message for correct number of args
 static void usage(const char *prog) {
     fprintf(stderr, "Error: %s <datafile> <p1> <p2> <p3> <p4>\n", prog);
+    fprintf(stderr, "       %s --bench <datafile> [min_refs]\n", prog);
+    fprintf(stderr, "       %s --curve <datafile> [max_frames]\n", prog);
+    fprintf(stderr, "       %s --allocate <datafile> <frames> [refs | w1 w2 w3 w4]\n", prog);
+    fprintf(stderr, "       %s --policy <name|all> <datafile> <p1> <p2> <p3> <p4>\n", prog);
+    fprintf(stderr, "       %s --procs <datafile> <frames|config> [policy]\n", prog);
 }
 
 // Move a found page to the MRU position
-static void lru_touch(lru_t *l, int page, int idx) {
+static void lru_touch(lru_t *l, page_t page, int idx) {
     for (int i = idx; i < l->size - 1; ++i)
         l->q[i] = l->q[i + 1];
     l->q[l->size - 1] = page;
 }
 
 // insert a new page
-static void lru_insert(lru_t *l, int page) {
+static void lru_insert(lru_t *l, page_t page) {
     if (l->cap <= 0) return; 
     if (l->size < l->cap) {
         l->q[l->size++] = page;
@@ -51,7 +314,7 @@ static void lru_insert(lru_t *l, int page) {
 }
 
 // access a page, return 1 if hit, 0 if miss
-static int lru_access(lru_t *l, int page) {
+static int lru_access(lru_t *l, page_t page) {
     for (int i = 0; i < l->size; ++i) {
         if (l->q[i] == page) {
             lru_touch(l, page, i);
@@ -62,88 +325,1918 @@ static int lru_access(lru_t *l, int page) {
     return 0;
 }
 
+// multiplicative hash of a page number for the open-addressing tables
+static unsigned page_hash(page_t page) {
+    unsigned long long h = (unsigned long long)page * 0x9E3779B97F4A7C15ull;
+    return (unsigned)(h >> 32);
+}
+
+// home slot of a page
+static unsigned hlru_hash(const hlru_t *l, page_t page) {
+    return page_hash(page) & l->mask;
+}
+
+// allocate a hashed LRU of cap frames (table at least twice cap),
+// return 0 or -1 if out of memory
+static int hlru_init(hlru_t *l, int cap) {
+    memset(l, 0, sizeof(*l));
+    l->head = l->tail = l->free_head = -1;
+    l->cap = cap;
+    if (cap <= 0) return 0;
+    unsigned size = 2;
+    while (size < 2u * (unsigned)cap) size <<= 1;
+    l->mask = size - 1;
+    l->nodes = (lru_node_t *)malloc((size_t)cap * sizeof(lru_node_t));
+    l->table = (int *)malloc((size_t)size * sizeof(int));
+    if (!l->nodes || !l->table) {
+        free(l->nodes);
+        free(l->table);
+        l->nodes = NULL;
+        l->table = NULL;
+        return -1;
+    }
+    memset(l->table, 0xff, (size_t)size * sizeof(int));
+    return 0;
+}
+
+static void hlru_free(hlru_t *l) {
+    free(l->nodes);
+    free(l->table);
+    l->nodes = NULL;
+    l->table = NULL;
+}
+
+// detach node n from the list
+static void hlru_unlink(hlru_t *l, int n) {
+    lru_node_t *x = &l->nodes[n];
+    if (x->prev >= 0) l->nodes[x->prev].next = x->next;
+    else l->head = x->next;
+    if (x->next >= 0) l->nodes[x->next].prev = x->prev;
+    else l->tail = x->prev;
+}
 
-int main(int argc, char *argv[]) {
-    if (argc != 6) {
-        usage(argv[0]);
-        return 1;
+// attach node n at the MRU end
+static void hlru_push_front(hlru_t *l, int n) {
+    l->nodes[n].prev = -1;
+    l->nodes[n].next = l->head;
+    if (l->head >= 0) l->nodes[l->head].prev = n;
+    l->head = n;
+    if (l->tail < 0) l->tail = n;
+}
+
+// empty a table slot, shifting later entries of the probe run back so
+// lookups never need tombstones
+static void hlru_unmap(hlru_t *l, unsigned slot) {
+    unsigned hole = slot;
+    for (unsigned i = (slot + 1) & l->mask; l->table[i] >= 0; i = (i + 1) & l->mask) {
+        unsigned home = hlru_hash(l, l->nodes[l->table[i]].page);
+        // the entry may fill the hole if the hole lies on its probe path
+        if (((i - home) & l->mask) >= ((i - hole) & l->mask)) {
+            l->table[hole] = l->table[i];
+            hole = i;
+        }
     }
+    l->table[hole] = -1;
+}
 
-    const char *datafile = argv[1];
+// drop the LRU page and return it (-1 if empty)
+static page_t hlru_evict(hlru_t *l) {
+    int n = l->tail;
+    if (n < 0) return -1;
+    hlru_unlink(l, n);
+    unsigned slot = hlru_hash(l, l->nodes[n].page);
+    while (l->table[slot] != n) slot = (slot + 1) & l->mask;
+    hlru_unmap(l, slot);
+    l->nodes[n].next = l->free_head;
+    l->free_head = n;
+    l->size--;
+    return l->nodes[n].page;
+}
 
-    // Get frame counts for each process
-    int caps[PROCS];
-    for (int i = 0; i < PROCS; ++i) {
-        caps[i] = atoi(argv[2 + i]);
-        if (caps[i] < 0) {
-            fprintf(stderr, "Frame counts must be non-negative.\n");
+// move a resident page to the MRU end, return 1 if it was resident
+static int hlru_touch(hlru_t *l, page_t page) {
+    if (l->cap <= 0) return 0;
+    unsigned slot = hlru_hash(l, page);
+    while (l->table[slot] >= 0) {
+        int n = l->table[slot];
+        if (l->nodes[n].page == page) {
+            if (n != l->head) {
+                hlru_unlink(l, n);
+                hlru_push_front(l, n);
+            }
             return 1;
         }
+        slot = (slot + 1) & l->mask;
     }
+    return 0;
+}
 
-    // open input data file
-    FILE *fp = fopen(datafile, "r");
-    if (!fp) {
-        perror("fopen");
+// load a missing page at the MRU end; a frame must be free
+static void hlru_insert(hlru_t *l, page_t page) {
+    unsigned slot = hlru_hash(l, page);
+    while (l->table[slot] >= 0) slot = (slot + 1) & l->mask;
+    int n = l->free_head;
+    if (n >= 0) l->free_head = l->nodes[n].next;
+    else n = l->fresh++;
+    l->size++;
+    l->nodes[n].page = page;
+    l->table[slot] = n;
+    hlru_push_front(l, n);
+}
+
+// access a page, return 1 if hit, 0 if miss
+static int hlru_access(hlru_t *l, page_t page) {
+    if (hlru_touch(l, page)) return 1;
+    if (l->cap <= 0) return 0;
+    if (l->size == l->cap) hlru_evict(l);
+    hlru_insert(l, page);
+    return 0;
+}
+
+// allocate a map for up to 'entries' pages, return 0 or -1
+static int imap_init(imap_t *m, int entries) {
+    unsigned size = 2;
+    while (size < 2u * (unsigned)entries) size <<= 1;
+    m->mask = size - 1;
+    m->keys = (page_t *)malloc((size_t)size * sizeof(page_t));
+    m->vals = (int *)malloc((size_t)size * sizeof(int));
+    if (!m->keys || !m->vals) {
+        free(m->keys);
+        free(m->vals);
+        m->keys = NULL;
+        m->vals = NULL;
+        return -1;
+    }
+    memset(m->vals, 0xff, (size_t)size * sizeof(int));
+    return 0;
+}
+
+static void imap_free(imap_t *m) {
+    free(m->keys);
+    free(m->vals);
+    m->keys = NULL;
+    m->vals = NULL;
+}
+
+// slot holding page, or the empty slot where it would go
+static unsigned imap_slot(const imap_t *m, page_t page) {
+    unsigned slot = page_hash(page) & m->mask;
+    while (m->vals[slot] >= 0 && m->keys[slot] != page)
+        slot = (slot + 1) & m->mask;
+    return slot;
+}
+
+// value stored for page, -1 if absent
+static int imap_get(const imap_t *m, page_t page) {
+    return m->vals[imap_slot(m, page)];
+}
+
+static void imap_put(imap_t *m, page_t page, int val) {
+    unsigned slot = imap_slot(m, page);
+    m->keys[slot] = page;
+    m->vals[slot] = val;
+}
+
+// remove page, shifting later entries of its probe run back
+static void imap_del(imap_t *m, page_t page) {
+    unsigned hole = imap_slot(m, page);
+    if (m->vals[hole] < 0) return;
+    for (unsigned i = (hole + 1) & m->mask; m->vals[i] >= 0; i = (i + 1) & m->mask) {
+        unsigned home = page_hash(m->keys[i]) & m->mask;
+        if (((i - home) & m->mask) >= ((i - hole) & m->mask)) {
+            m->keys[hole] = m->keys[i];
+            m->vals[hole] = m->vals[i];
+            hole = i;
+        }
+    }
+    m->vals[hole] = -1;
+}
+
+static int pool_init(pool_t *pl, int cap) {
+    pl->nodes = (pnode_t *)malloc((size_t)cap * sizeof(pnode_t));
+    pl->free_head = -1;
+    pl->fresh = 0;
+    return pl->nodes ? 0 : -1;
+}
+
+// take a node; callers size the pool so it never runs dry
+static int pool_get(pool_t *pl) {
+    if (pl->free_head < 0) return pl->fresh++;
+    int n = pl->free_head;
+    pl->free_head = pl->nodes[n].next;
+    return n;
+}
+
+static void pool_put(pool_t *pl, int n) {
+    pl->nodes[n].next = pl->free_head;
+    pl->free_head = n;
+}
+
+static void plist_init(plist_t *l) {
+    l->head = l->tail = -1;
+    l->size = 0;
+}
+
+// attach node n at the head
+static void plist_push(pnode_t *nodes, plist_t *l, int n) {
+    nodes[n].prev = -1;
+    nodes[n].next = l->head;
+    if (l->head >= 0) nodes[l->head].prev = n;
+    l->head = n;
+    if (l->tail < 0) l->tail = n;
+    l->size++;
+}
+
+static void plist_remove(pnode_t *nodes, plist_t *l, int n) {
+    if (nodes[n].prev >= 0) nodes[nodes[n].prev].next = nodes[n].next;
+    else l->head = nodes[n].next;
+    if (nodes[n].next >= 0) nodes[nodes[n].next].prev = nodes[n].prev;
+    else l->tail = nodes[n].prev;
+    l->size--;
+}
+
+// LRU: the hashed list above
+static void *lru_p_init(int frames) {
+    hlru_t *l = (hlru_t *)malloc(sizeof(hlru_t));
+    if (!l || hlru_init(l, frames) != 0) {
+        free(l);
+        return NULL;
+    }
+    return l;
+}
+
+static int lru_p_access(void *st, page_t page, long next_use) {
+    (void)next_use;
+    return hlru_touch((hlru_t *)st, page);
+}
+
+static page_t lru_p_evict(void *st) {
+    return hlru_evict((hlru_t *)st);
+}
+
+static void lru_p_insert(void *st, page_t page, long next_use) {
+    (void)next_use;
+    hlru_insert((hlru_t *)st, page);
+}
+
+static void lru_p_destroy(void *st) {
+    hlru_free((hlru_t *)st);
+    free(st);
+}
+
+// FIFO
+static void *fifo_init(int frames) {
+    fifo_t *f = (fifo_t *)calloc(1, sizeof(fifo_t));
+    if (!f) return NULL;
+    f->cap = frames;
+    f->ring = (page_t *)malloc((size_t)frames * sizeof(page_t));
+    if (!f->ring || imap_init(&f->map, frames) != 0) {
+        free(f->ring);
+        free(f);
+        return NULL;
+    }
+    return f;
+}
+
+static page_t fifo_evict(void *st) {
+    fifo_t *f = (fifo_t *)st;
+    page_t page = f->ring[f->head];
+    f->head = (f->head + 1) % f->cap;
+    f->size--;
+    imap_del(&f->map, page);
+    return page;
+}
+
+static int fifo_access(void *st, page_t page, long next_use) {
+    (void)next_use;
+    return imap_get(&((fifo_t *)st)->map, page) >= 0;
+}
+
+static void fifo_insert(void *st, page_t page, long next_use) {
+    fifo_t *f = (fifo_t *)st;
+    (void)next_use;
+    f->ring[(f->head + f->size) % f->cap] = page;
+    f->size++;
+    imap_put(&f->map, page, 0);
+}
+
+static void fifo_destroy(void *st) {
+    fifo_t *f = (fifo_t *)st;
+    free(f->ring);
+    imap_free(&f->map);
+    free(f);
+}
+
+// CLOCK: pages load with the bit clear, so only a hit earns a second
+// chance; the hand passes the victim's frame, which the next insert fills
+static void *clk_init(int frames) {
+    clk_t *c = (clk_t *)calloc(1, sizeof(clk_t));
+    if (!c) return NULL;
+    c->cap = frames;
+    c->spare = -1;
+    c->pages = (page_t *)malloc((size_t)frames * sizeof(page_t));
+    c->ref = (unsigned char *)calloc((size_t)frames, 1);
+    if (!c->pages || !c->ref || imap_init(&c->map, frames) != 0) {
+        free(c->pages);
+        free(c->ref);
+        free(c);
+        return NULL;
+    }
+    return c;
+}
+
+static page_t clk_evict(void *st) {
+    clk_t *c = (clk_t *)st;
+    while (c->ref[c->hand]) {
+        c->ref[c->hand] = 0;
+        c->hand = (c->hand + 1) % c->cap;
+    }
+    page_t page = c->pages[c->hand];
+    imap_del(&c->map, page);
+    c->spare = c->hand;
+    c->hand = (c->hand + 1) % c->cap;
+    c->size--;
+    return page;
+}
+
+static int clk_access(void *st, page_t page, long next_use) {
+    clk_t *c = (clk_t *)st;
+    (void)next_use;
+    int f = imap_get(&c->map, page);
+    if (f < 0) return 0;
+    c->ref[f] = 1;
+    return 1;
+}
+
+static void clk_insert(void *st, page_t page, long next_use) {
+    clk_t *c = (clk_t *)st;
+    (void)next_use;
+    int f = c->spare >= 0 ? c->spare : c->size;
+    c->spare = -1;
+    c->size++;
+    c->pages[f] = page;
+    c->ref[f] = 0;
+    imap_put(&c->map, page, f);
+}
+
+static void clk_destroy(void *st) {
+    clk_t *c = (clk_t *)st;
+    free(c->pages);
+    free(c->ref);
+    imap_free(&c->map);
+    free(c);
+}
+
+// CLOCK-Pro (Jiang, Chen and Zhang, 2005), in the common simplified
+// form where every resident cold page is in its test period. New pages
+// go in just behind hand_hot; a hand passing a node moves it forward.
+static void cp_run_hand_cold(cpro_t *c);
+
+static void *cpro_init(int frames) {
+    cpro_t *c = (cpro_t *)calloc(1, sizeof(cpro_t));
+    if (!c) return NULL;
+    c->cap = frames;
+    c->mem_cold = frames;
+    c->pending = -1;
+    c->hand_hot = c->hand_cold = c->hand_test = -1;
+    if (pool_init(&c->pool, 2 * frames + 2) != 0 || imap_init(&c->map, 2 * frames + 2) != 0) {
+        free(c->pool.nodes);
+        free(c);
+        return NULL;
+    }
+    return c;
+}
+
+// insert node n just behind hand_hot
+static void cp_link(cpro_t *c, int n) {
+    pnode_t *nodes = c->pool.nodes;
+    if (c->hand_hot < 0) {
+        nodes[n].prev = nodes[n].next = n;
+        c->hand_hot = c->hand_cold = c->hand_test = n;
+        return;
+    }
+    int after = nodes[c->hand_hot].prev;
+    nodes[n].prev = after;
+    nodes[n].next = c->hand_hot;
+    nodes[after].next = n;
+    nodes[c->hand_hot].prev = n;
+    if (c->hand_cold == c->hand_hot) c->hand_cold = n;
+}
+
+// take node n out of the ring; hands on it step back
+static void cp_unlink(cpro_t *c, int n) {
+    pnode_t *nodes = c->pool.nodes;
+    if (nodes[n].next == n) {
+        c->hand_hot = c->hand_cold = c->hand_test = -1;
+        return;
+    }
+    if (c->hand_hot == n) c->hand_hot = nodes[n].prev;
+    if (c->hand_cold == n) c->hand_cold = nodes[n].prev;
+    if (c->hand_test == n) c->hand_test = nodes[n].prev;
+    nodes[nodes[n].prev].next = nodes[n].next;
+    nodes[nodes[n].next].prev = nodes[n].prev;
+}
+
+// end the test period under hand_test: a non-resident page leaves the
+// ring and the cold target shrinks
+static void cp_run_hand_test(cpro_t *c) {
+    if (c->hand_test == c->hand_cold) cp_run_hand_cold(c);
+    int n = c->hand_test;
+    if (n < 0) return;
+    pnode_t *nodes = c->pool.nodes;
+    if (nodes[n].tag == CP_TEST) {
+        int prev = nodes[n].prev;
+        cp_unlink(c, n);
+        imap_del(&c->map, nodes[n].page);
+        pool_put(&c->pool, n);
+        c->hand_test = c->hand_test < 0 ? -1 : prev;
+        c->count_test--;
+        if (c->mem_cold > 1) c->mem_cold--;
+    }
+    if (c->hand_test >= 0) c->hand_test = nodes[c->hand_test].next;
+}
+
+// demote an unreferenced hot page under hand_hot to cold
+static void cp_run_hand_hot(cpro_t *c) {
+    if (c->hand_hot == c->hand_test) cp_run_hand_test(c);
+    pnode_t *x = &c->pool.nodes[c->hand_hot];
+    if (x->tag == CP_HOT) {
+        if (x->ref) {
+            x->ref = 0;
+        } else {
+            x->tag = CP_COLD;
+            c->count_hot--;
+            c->count_cold++;
+        }
+    }
+    c->hand_hot = x->next;
+}
+
+// a referenced cold page under hand_cold turns hot; an unreferenced
+// one is evicted but stays in the ring as a test page, unless no
+// eviction is owed (the hand was pushed on by hand_test), when it waits
+static void cp_run_hand_cold(cpro_t *c) {
+    pnode_t *x = &c->pool.nodes[c->hand_cold];
+    if (x->tag == CP_COLD) {
+        if (x->ref) {
+            x->tag = CP_HOT;
+            x->ref = 0;
+            c->count_cold--;
+            c->count_hot++;
+        } else if (c->owed > 0) {
+            x->tag = CP_TEST;
+            c->victim = x->page;
+            c->owed--;
+            c->count_cold--;
+            c->count_test++;
+            while (c->cap < c->count_test) cp_run_hand_test(c);
+        }
+    }
+    c->hand_cold = c->pool.nodes[c->hand_cold].next;
+}
+
+// hand_hot runs after each hand_cold step rather than inside it, so the
+// hands cannot chase each other forever on a one-node ring
+static page_t cpro_evict(void *st) {
+    cpro_t *c = (cpro_t *)st;
+    c->owed = 1;
+    while (c->owed > 0) {
+        cp_run_hand_cold(c);
+        while (c->cap - c->mem_cold < c->count_hot) cp_run_hand_hot(c);
+    }
+    return c->victim;
+}
+
+static int cpro_access(void *st, page_t page, long next_use) {
+    cpro_t *c = (cpro_t *)st;
+    (void)next_use;
+    int n = imap_get(&c->map, page);
+    c->pending = -1;
+    if (n >= 0 && c->pool.nodes[n].tag != CP_TEST) {
+        c->pool.nodes[n].ref = 1;
         return 1;
     }
+    if (n >= 0) {
+        // faulted during its test period: grow the cold target and take
+        // it off the ring, so the hands pass it while a frame is freed
+        if (c->mem_cold < c->cap) c->mem_cold++;
+        c->count_test--;
+        cp_unlink(c, n);
+        c->pending = n;
+    }
+    return 0;
+}
 
-    // initialize LRU caches for each process
-    lru_t lru[PROCS];
-    int *bufs[PROCS] = {0};
-    for (int p = 0; p < PROCS; ++p) {
-        if (caps[p] > 0) {
-            bufs[p] = (int *)malloc((size_t)caps[p] * sizeof(int));
-            if (!bufs[p]) {
-                perror("malloc");
-                fclose(fp);
-                for (int k = 0; k < p; ++k) free(bufs[k]);
-                return 1;
-            }
+static void cpro_insert(void *st, page_t page, long next_use) {
+    cpro_t *c = (cpro_t *)st;
+    (void)next_use;
+    int n = c->pending;
+    if (n >= 0) {
+        // reload a faulted test page hot
+        c->pending = -1;
+        c->pool.nodes[n].tag = CP_HOT;
+        c->pool.nodes[n].ref = 0;
+        cp_link(c, n);
+        c->count_hot++;
+        return;
+    }
+    n = pool_get(&c->pool);
+    c->pool.nodes[n].page = page;
+    c->pool.nodes[n].tag = CP_COLD;
+    c->pool.nodes[n].ref = 0;
+    cp_link(c, n);
+    imap_put(&c->map, page, n);
+    c->count_cold++;
+}
+
+static void cpro_destroy(void *st) {
+    cpro_t *c = (cpro_t *)st;
+    free(c->pool.nodes);
+    imap_free(&c->map);
+    free(c);
+}
+
+// LFU with O(1) frequency buckets; ties go to the least recently used
+static void *lfu_init(int frames) {
+    lfu_t *l = (lfu_t *)calloc(1, sizeof(lfu_t));
+    if (!l) return NULL;
+    l->cap = frames;
+    l->bfirst = -1;
+    l->buckets = (lfu_bucket_t *)malloc(((size_t)frames + 1) * sizeof(lfu_bucket_t));
+    if (!l->buckets || pool_init(&l->pool, frames) != 0 || imap_init(&l->map, frames) != 0) {
+        free(l->buckets);
+        free(l->pool.nodes);
+        free(l);
+        return NULL;
+    }
+    for (int b = 0; b <= frames; ++b) l->buckets[b].next = b < frames ? b + 1 : -1;
+    l->bfree = 0;
+    return l;
+}
+
+// new empty bucket for freq, linked after bucket 'after' (-1: first)
+static int lfu_new_bucket(lfu_t *l, long freq, int after) {
+    int b = l->bfree;
+    lfu_bucket_t *x = &l->buckets[b];
+    l->bfree = x->next;
+    x->freq = freq;
+    plist_init(&x->pages);
+    x->prev = after;
+    x->next = after >= 0 ? l->buckets[after].next : l->bfirst;
+    if (x->next >= 0) l->buckets[x->next].prev = b;
+    if (after >= 0) l->buckets[after].next = b;
+    else l->bfirst = b;
+    return b;
+}
+
+// unlink bucket b if it has emptied
+static void lfu_drop_bucket(lfu_t *l, int b) {
+    lfu_bucket_t *x = &l->buckets[b];
+    if (x->pages.size > 0) return;
+    if (x->prev >= 0) l->buckets[x->prev].next = x->next;
+    else l->bfirst = x->next;
+    if (x->next >= 0) l->buckets[x->next].prev = x->prev;
+    x->next = l->bfree;
+    l->bfree = b;
+}
+
+static page_t lfu_evict(void *st) {
+    lfu_t *l = (lfu_t *)st;
+    int b = l->bfirst;
+    int n = l->buckets[b].pages.tail;
+    page_t page = l->pool.nodes[n].page;
+    plist_remove(l->pool.nodes, &l->buckets[b].pages, n);
+    lfu_drop_bucket(l, b);
+    imap_del(&l->map, page);
+    pool_put(&l->pool, n);
+    l->size--;
+    return page;
+}
+
+static int lfu_access(void *st, page_t page, long next_use) {
+    lfu_t *l = (lfu_t *)st;
+    pnode_t *nodes = l->pool.nodes;
+    (void)next_use;
+    int n = imap_get(&l->map, page);
+    if (n >= 0) {
+        int b = nodes[n].tag;
+        int nb = l->buckets[b].next;
+        if (nb < 0 || l->buckets[nb].freq != l->buckets[b].freq + 1)
+            nb = lfu_new_bucket(l, l->buckets[b].freq + 1, b);
+        plist_remove(nodes, &l->buckets[b].pages, n);
+        plist_push(nodes, &l->buckets[nb].pages, n);
+        nodes[n].tag = nb;
+        lfu_drop_bucket(l, b);
+        return 1;
+    }
+    return 0;
+}
+
+static void lfu_insert(void *st, page_t page, long next_use) {
+    lfu_t *l = (lfu_t *)st;
+    pnode_t *nodes = l->pool.nodes;
+    (void)next_use;
+    int b = l->bfirst;
+    if (b < 0 || l->buckets[b].freq != 1) b = lfu_new_bucket(l, 1, -1);
+    int n = pool_get(&l->pool);
+    nodes[n].page = page;
+    nodes[n].tag = b;
+    plist_push(nodes, &l->buckets[b].pages, n);
+    imap_put(&l->map, page, n);
+    l->size++;
+}
+
+static void lfu_destroy(void *st) {
+    lfu_t *l = (lfu_t *)st;
+    free(l->buckets);
+    free(l->pool.nodes);
+    imap_free(&l->map);
+    free(l);
+}
+
+// ARC (Megiddo and Modha, 2003)
+static void *arc_init(int frames) {
+    arc_t *a = (arc_t *)calloc(1, sizeof(arc_t));
+    if (!a) return NULL;
+    a->cap = frames;
+    a->pending = -1;
+    for (int i = 0; i < 4; ++i) plist_init(&a->lists[i]);
+    if (pool_init(&a->pool, 2 * frames + 1) != 0 || imap_init(&a->map, 2 * frames + 1) != 0) {
+        free(a->pool.nodes);
+        free(a);
+        return NULL;
+    }
+    return a;
+}
+
+// move node n to the head of list 'to'
+static void arc_move(arc_t *a, int n, int to) {
+    plist_remove(a->pool.nodes, &a->lists[a->pool.nodes[n].tag], n);
+    plist_push(a->pool.nodes, &a->lists[to], n);
+    a->pool.nodes[n].tag = to;
+}
+
+// forget the LRU entry of a list
+static void arc_drop(arc_t *a, int list) {
+    int n = a->lists[list].tail;
+    plist_remove(a->pool.nodes, &a->lists[list], n);
+    imap_del(&a->map, a->pool.nodes[n].page);
+    pool_put(&a->pool, n);
+}
+
+// REPLACE: evict from T1 into B1 when T1 is over its target, otherwise
+// from T2 into B2
+static page_t arc_replace(arc_t *a, int in_b2) {
+    int t1 = a->lists[ARC_T1].size;
+    int from = ARC_T2, to = ARC_B2;
+    if (t1 >= 1 && ((in_b2 && t1 == a->p) || t1 > a->p || a->lists[ARC_T2].size == 0)) {
+        from = ARC_T1;
+        to = ARC_B1;
+    }
+    int n = a->lists[from].tail;
+    arc_move(a, n, to);
+    return a->pool.nodes[n].page;
+}
+
+// the cache is full, so every miss needs a frame: a ghost hit runs
+// REPLACE, a new page too unless T1 fills the cache and its LRU page is
+// dropped outright
+static page_t arc_evict(void *st) {
+    arc_t *a = (arc_t *)st;
+    if (a->pending < 0 && a->lists[ARC_T1].size == a->cap) {
+        int n = a->lists[ARC_T1].tail;
+        page_t page = a->pool.nodes[n].page;
+        arc_drop(a, ARC_T1);
+        return page;
+    }
+    return arc_replace(a, a->pending >= 0 && a->pool.nodes[a->pending].tag == ARC_B2);
+}
+
+// a miss adapts the target on a ghost hit, or trims the directory for a
+// new page; evict and insert finish it
+static int arc_access(void *st, page_t page, long next_use) {
+    arc_t *a = (arc_t *)st;
+    (void)next_use;
+    plist_t *L = a->lists;
+    int n = imap_get(&a->map, page);
+    a->pending = -1;
+    if (n >= 0) {
+        int tag = a->pool.nodes[n].tag;
+        if (tag == ARC_T1 || tag == ARC_T2) {
+            arc_move(a, n, ARC_T2);
+            return 1;
+        }
+        // ghost hit: shift the target toward the list that would have hit
+        if (tag == ARC_B1) {
+            int d = L[ARC_B2].size / L[ARC_B1].size;
+            a->p += d > 1 ? d : 1;
+            if (a->p > a->cap) a->p = a->cap;
+        } else {
+            int d = L[ARC_B1].size / L[ARC_B2].size;
+            a->p -= d > 1 ? d : 1;
+            if (a->p < 0) a->p = 0;
         }
-        lru[p].q = bufs[p];
-        lru[p].size = 0;
-        lru[p].cap  = caps[p];
+        a->pending = n;
+        return 0;
     }
 
-    // initialize hit and reference counters
-    long hits[PROCS] = {0,0,0,0};
-    long refs[PROCS] = {0,0,0,0};
+    // new page: keep T1 + B1 <= c and the directory <= 2c (a full T1
+    // loses its LRU page in evict instead)
+    int total = L[ARC_T1].size + L[ARC_T2].size + L[ARC_B1].size + L[ARC_B2].size;
+    if (L[ARC_T1].size + L[ARC_B1].size == a->cap) {
+        if (L[ARC_T1].size < a->cap) arc_drop(a, ARC_B1);
+    } else if (total == 2 * a->cap) {
+        arc_drop(a, ARC_B2);
+    }
+    return 0;
+}
 
-    // process each line of input
-    char line[MAX_LINE];
-    while (fgets(line, sizeof(line), fp)) {
-        if (line[0] == '\n' || line[0] == '\r' || line[0] == '#') continue;
-        // Read proc and page from data file
-        int proc = 0, page = 0;
-        if (sscanf(line, "%d %d", &proc, &page) != 2) continue;
-        if (proc < 1 || proc > PROCS) continue;
-        // update reference and hit counters
-        int idx = proc - 1;
-        refs[idx]++;
-        if (lru_access(&lru[idx], page))
-            hits[idx]++;
+static void arc_insert(void *st, page_t page, long next_use) {
+    arc_t *a = (arc_t *)st;
+    (void)next_use;
+    int n = a->pending;
+    if (n >= 0) {
+        a->pending = -1;
+        arc_move(a, n, ARC_T2);
+        return;
     }
-    fclose(fp);
+    n = pool_get(&a->pool);
+    a->pool.nodes[n].page = page;
+    a->pool.nodes[n].tag = ARC_T1;
+    plist_push(a->pool.nodes, &a->lists[ARC_T1], n);
+    imap_put(&a->map, page, n);
+}
 
-    // compute percentages and averages
-    double pct[PROCS];
-    double avg = 0.0;
-    for (int i = 0; i < PROCS; ++i) {
-        pct[i] = (refs[i] > 0) ? (100.0 * (double)hits[i] / (double)refs[i]) : 0.0;
-        avg += pct[i];
+static void arc_destroy(void *st) {
+    arc_t *a = (arc_t *)st;
+    free(a->pool.nodes);
+    imap_free(&a->map);
+    free(a);
+}
+
+// 2Q (Johnson and Shasha, 1994), full version: Kin = c/4, Kout = c/2
+static void *twoq_init(int frames) {
+    twoq_t *q = (twoq_t *)calloc(1, sizeof(twoq_t));
+    if (!q) return NULL;
+    q->cap = frames;
+    q->kin = frames / 4 > 1 ? frames / 4 : 1;
+    q->kout = frames / 2 > 1 ? frames / 2 : 1;
+    q->pending = -1;
+    for (int i = 0; i < 3; ++i) plist_init(&q->lists[i]);
+    int nodes = frames + q->kout + 1;
+    if (pool_init(&q->pool, nodes) != 0 || imap_init(&q->map, nodes) != 0) {
+        free(q->pool.nodes);
+        free(q);
+        return NULL;
     }
-    avg /= PROCS;
+    return q;
+}
 
-    // Print results
-    printf("P1=%d%%  P2=%d%%  P3=%d%%  P4=%d%%  AVG=%d%%\n",
-           (int)(pct[0] + 0.5), (int)(pct[1] + 0.5),
-           (int)(pct[2] + 0.5), (int)(pct[3] + 0.5),
-           (int)(avg + 0.5));
+// page out A1in's oldest (remembered in A1out) while A1in is over Kin,
+// else Am's LRU page
+static page_t twoq_evict(void *st) {
+    twoq_t *q = (twoq_t *)st;
+    pnode_t *nodes = q->pool.nodes;
+    plist_t *L = q->lists;
+    if (L[Q_A1IN].size > q->kin || L[Q_AM].size == 0) {
+        int n = L[Q_A1IN].tail;
+        plist_remove(nodes, &L[Q_A1IN], n);
+        if (L[Q_A1OUT].size >= q->kout) {
+            int old = L[Q_A1OUT].tail;
+            plist_remove(nodes, &L[Q_A1OUT], old);
+            imap_del(&q->map, nodes[old].page);
+            pool_put(&q->pool, old);
+        }
+        plist_push(nodes, &L[Q_A1OUT], n);
+        nodes[n].tag = Q_A1OUT;
+        return nodes[n].page;
+    }
+    int n = L[Q_AM].tail;
+    page_t page = nodes[n].page;
+    plist_remove(nodes, &L[Q_AM], n);
+    imap_del(&q->map, page);
+    pool_put(&q->pool, n);
+    return page;
+}
+
+static int twoq_access(void *st, page_t page, long next_use) {
+    twoq_t *q = (twoq_t *)st;
+    pnode_t *nodes = q->pool.nodes;
+    plist_t *L = q->lists;
+    (void)next_use;
+    int n = imap_get(&q->map, page);
+    q->pending = -1;
+    if (n >= 0 && nodes[n].tag == Q_AM) {
+        plist_remove(nodes, &L[Q_AM], n);
+        plist_push(nodes, &L[Q_AM], n);
+        return 1;
+    }
+    if (n >= 0 && nodes[n].tag == Q_A1IN) return 1;
+    if (n >= 0) {
+        // remembered from A1out: detach before eviction can recycle it
+        plist_remove(nodes, &L[Q_A1OUT], n);
+        q->pending = n;
+    }
+    return 0;
+}
+
+static void twoq_insert(void *st, page_t page, long next_use) {
+    twoq_t *q = (twoq_t *)st;
+    pnode_t *nodes = q->pool.nodes;
+    plist_t *L = q->lists;
+    (void)next_use;
+    int n = q->pending;
+    if (n >= 0) {
+        q->pending = -1;
+        plist_push(nodes, &L[Q_AM], n);
+        nodes[n].tag = Q_AM;
+        return;
+    }
+    n = pool_get(&q->pool);
+    nodes[n].page = page;
+    nodes[n].tag = Q_A1IN;
+    plist_push(nodes, &L[Q_A1IN], n);
+    imap_put(&q->map, page, n);
+}
+
+static void twoq_destroy(void *st) {
+    twoq_t *q = (twoq_t *)st;
+    free(q->pool.nodes);
+    imap_free(&q->map);
+    free(q);
+}
+
+// OPT: evict the resident page whose next use is farthest away
+static void *opt_init(int frames) {
+    opt_t *o = (opt_t *)calloc(1, sizeof(opt_t));
+    if (!o) return NULL;
+    o->cap = frames;
+    o->spare = -1;
+    o->page = (page_t *)malloc((size_t)frames * sizeof(page_t));
+    o->key = (long *)malloc((size_t)frames * sizeof(long));
+    o->heap = (int *)malloc((size_t)frames * sizeof(int));
+    o->pos = (int *)malloc((size_t)frames * sizeof(int));
+    if (!o->page || !o->key || !o->heap || !o->pos || imap_init(&o->map, frames) != 0) {
+        free(o->page);
+        free(o->key);
+        free(o->heap);
+        free(o->pos);
+        free(o);
+        return NULL;
+    }
+    return o;
+}
+
+static void opt_swap(opt_t *o, int i, int j) {
+    int t = o->heap[i];
+    o->heap[i] = o->heap[j];
+    o->heap[j] = t;
+    o->pos[o->heap[i]] = i;
+    o->pos[o->heap[j]] = j;
+}
+
+static void opt_sift_up(opt_t *o, int i) {
+    while (i > 0 && o->key[o->heap[(i - 1) / 2]] < o->key[o->heap[i]]) {
+        opt_swap(o, i, (i - 1) / 2);
+        i = (i - 1) / 2;
+    }
+}
+
+static void opt_sift_down(opt_t *o, int i) {
+    for (;;) {
+        int big = i, l = 2 * i + 1, r = 2 * i + 2;
+        if (l < o->size && o->key[o->heap[l]] > o->key[o->heap[big]]) big = l;
+        if (r < o->size && o->key[o->heap[r]] > o->key[o->heap[big]]) big = r;
+        if (big == i) return;
+        opt_swap(o, i, big);
+        i = big;
+    }
+}
+
+static page_t opt_evict(void *st) {
+    opt_t *o = (opt_t *)st;
+    int f = o->heap[0];
+    opt_swap(o, 0, --o->size);
+    opt_sift_down(o, 0);
+    imap_del(&o->map, o->page[f]);
+    o->spare = f;
+    return o->page[f];
+}
+
+static int opt_access(void *st, page_t page, long next_use) {
+    opt_t *o = (opt_t *)st;
+    int f = imap_get(&o->map, page);
+    if (f >= 0) {
+        // the next use only moves later, so the key can only rise
+        o->key[f] = next_use;
+        opt_sift_up(o, o->pos[f]);
+        return 1;
+    }
+    return 0;
+}
+
+static void opt_insert(void *st, page_t page, long next_use) {
+    opt_t *o = (opt_t *)st;
+    int f = o->spare >= 0 ? o->spare : o->size;
+    o->spare = -1;
+    o->page[f] = page;
+    o->key[f] = next_use;
+    o->heap[o->size] = f;
+    o->pos[f] = o->size;
+    opt_sift_up(o, o->size++);
+    imap_put(&o->map, page, f);
+}
+
+static void opt_destroy(void *st) {
+    opt_t *o = (opt_t *)st;
+    free(o->page);
+    free(o->key);
+    free(o->heap);
+    free(o->pos);
+    imap_free(&o->map);
+    free(o);
+}
+
+static const policy_t policies[] = {
+    { "lru",      lru_p_init, lru_p_access, lru_p_evict, lru_p_insert, lru_p_destroy },
+    { "fifo",     fifo_init,  fifo_access,  fifo_evict,  fifo_insert,  fifo_destroy },
+    { "clock",    clk_init,   clk_access,   clk_evict,   clk_insert,   clk_destroy },
+    { "clockpro", cpro_init,  cpro_access,  cpro_evict,  cpro_insert,  cpro_destroy },
+    { "lfu",      lfu_init,   lfu_access,   lfu_evict,   lfu_insert,   lfu_destroy },
+    { "arc",      arc_init,   arc_access,   arc_evict,   arc_insert,   arc_destroy },
+    { "2q",       twoq_init,  twoq_access,  twoq_evict,  twoq_insert,  twoq_destroy },
+    { "opt",      opt_init,   opt_access,   opt_evict,   opt_insert,   opt_destroy },
+};
+#define NUM_POLICIES ((int)(sizeof(policies) / sizeof(policies[0])))
+
+// one reference through pol for a process with frames > 0 and resident
+// pages loaded: on a miss free a frame if all are in use, then load the
+// page; return 1 on a hit
+static int policy_ref(const policy_t *pol, void *st, int frames, int *resident, page_t page,
+                      long next_use) {
+    if (pol->access(st, page, next_use)) return 1;
+    if (*resident == frames) pol->evict(st);
+    else (*resident)++;
+    pol->insert(st, page, next_use);
+    return 0;
+}
+
+// wall-clock seconds
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// read the whole trace into (0-based proc, page) arrays; return the
+// reference count, or -1 on error or an empty trace
+static long load_trace(const char *datafile, int **procs_out, page_t **pages_out) {
+    FILE *fp = fopen(datafile, "r");
+    if (!fp) {
+        perror("fopen");
+        return -1;
+    }
+    int *procs = NULL;
+    page_t *pages = NULL;
+    long n = 0, cap = 0;
+    char line[MAX_LINE];
+    while (fgets(line, sizeof(line), fp)) {
+        if (line[0] == '\n' || line[0] == '\r' || line[0] == '#') continue;
+        long long proc = 0;
+        page_t page = 0;
+        if (sscanf(line, "%lld %lld", &proc, &page) != 2) continue;
+        if (proc < 1 || proc > PROCS) continue;
+        if (n == cap) {
+            cap = cap ? cap * 2 : 4096;
+            int *np = (int *)realloc(procs, (size_t)cap * sizeof(int));
+            if (np) procs = np;
+            page_t *ng = (page_t *)realloc(pages, (size_t)cap * sizeof(page_t));
+            if (ng) pages = ng;
+            if (!np || !ng) {
+                perror("realloc");
+                fclose(fp);
+                free(procs);
+                free(pages);
+                return -1;
+            }
+        }
+        procs[n] = (int)proc - 1;
+        pages[n] = page;
+        n++;
+    }
+    fclose(fp);
+    if (n == 0) {
+        fprintf(stderr, "no references in %s\n", datafile);
+        free(procs);
+        free(pages);
+        return -1;
+    }
+    *procs_out = procs;
+    *pages_out = pages;
+    return n;
+}
+
+// replay the trace at each frame count with both LRUs; prints refs/s
+// and fails if their hit counts ever differ
+static int bench(const char *datafile, long min_refs) {
+    int *procs = NULL;
+    page_t *pages = NULL;
+    long n = load_trace(datafile, &procs, &pages);
+    if (n < 0) return 1;
+    long passes = (min_refs + n - 1) / n;
+
+    static const int frame_counts[] = { 1, 4, 16, 64, 256, 1024, 4096, 16384, 65536, 100000 };
+    int rc = 0;
+    printf("%8s %10s %14s %14s %8s\n", "frames", "hit%", "array ref/s", "hashed ref/s", "speedup");
+    for (size_t f = 0; f < sizeof(frame_counts) / sizeof(frame_counts[0]) && rc == 0; ++f) {
+        int frames = frame_counts[f];
+        lru_t lru[PROCS];
+        hlru_t hlru[PROCS];
+        long hits_array = 0, hits_hashed = 0;
+        for (int p = 0; p < PROCS; ++p) {
+            lru[p].q = (page_t *)malloc((size_t)frames * sizeof(page_t));
+            lru[p].size = 0;
+            lru[p].cap = frames;
+            // init every table even after a failure so all can be freed
+            int hrc = hlru_init(&hlru[p], frames);
+            if (!lru[p].q || hrc != 0) {
+                perror("malloc");
+                rc = 1;
+            }
+        }
+
+        double t0 = now_sec();
+        for (long r = 0; r < passes && rc == 0; ++r)
+            for (long i = 0; i < n; ++i)
+                hits_array += lru_access(&lru[procs[i]], pages[i]);
+        double t1 = now_sec();
+        for (long r = 0; r < passes && rc == 0; ++r)
+            for (long i = 0; i < n; ++i)
+                hits_hashed += hlru_access(&hlru[procs[i]], pages[i]);
+        double t2 = now_sec();
+
+        if (rc == 0) {
+            double refs = (double)passes * (double)n;
+            double ra = t1 > t0 ? refs / (t1 - t0) : 0.0;
+            double rh = t2 > t1 ? refs / (t2 - t1) : 0.0;
+            printf("%8d %10.2f %14.0f %14.0f %7.1fx\n", frames, 100.0 * (double)hits_hashed / refs,
+                   ra, rh, ra > 0.0 ? rh / ra : 0.0);
+            if (hits_array != hits_hashed) {
+                fprintf(stderr, "hit counts differ at %d frames: %ld vs %ld\n",
+                        frames, hits_array, hits_hashed);
+                rc = 1;
+            }
+        }
+        for (int p = 0; p < PROCS; ++p) {
+            free(lru[p].q);
+            hlru_free(&hlru[p]);
+        }
+    }
+    free(procs);
+    free(pages);
+    return rc;
+}
+
+// allocate an empty map with room for 'expect' pages before growing
+static int pmap_init(pmap_t *m, int expect) {
+    unsigned size = 16;
+    while (size < 2u * (unsigned)expect) size <<= 1;
+    m->mask = size - 1;
+    m->count = 0;
+    m->keys = (page_t *)malloc((size_t)size * sizeof(page_t));
+    m->vals = (long *)malloc((size_t)size * sizeof(long));
+    if (!m->keys || !m->vals) {
+        free(m->keys);
+        free(m->vals);
+        m->keys = NULL;
+        m->vals = NULL;
+        return -1;
+    }
+    memset(m->vals, 0xff, (size_t)size * sizeof(long));
+    return 0;
+}
+
+static void pmap_free(pmap_t *m) {
+    free(m->keys);
+    free(m->vals);
+    m->keys = NULL;
+    m->vals = NULL;
+}
+
+// slot holding page, or the empty slot where it would go
+static unsigned pmap_slot(const pmap_t *m, page_t page) {
+    unsigned slot = page_hash(page) & m->mask;
+    while (m->vals[slot] >= 0 && m->keys[slot] != page)
+        slot = (slot + 1) & m->mask;
+    return slot;
+}
+
+// set page's value (non-negative), doubling the table at half load;
+// return 0 or -1 if out of memory
+static int pmap_put(pmap_t *m, page_t page, long val) {
+    unsigned slot = pmap_slot(m, page);
+    if (m->vals[slot] < 0) {
+        if (2u * (unsigned)(m->count + 1) > m->mask + 1) {
+            pmap_t big;
+            if (pmap_init(&big, (int)(m->mask + 1)) != 0) return -1;
+            for (unsigned i = 0; i <= m->mask; ++i) {
+                if (m->vals[i] < 0) continue;
+                unsigned s = pmap_slot(&big, m->keys[i]);
+                big.keys[s] = m->keys[i];
+                big.vals[s] = m->vals[i];
+            }
+            big.count = m->count;
+            pmap_free(m);
+            *m = big;
+            slot = pmap_slot(m, page);
+        }
+        m->keys[slot] = page;
+        m->count++;
+    }
+    m->vals[slot] = val;
+    return 0;
+}
+
+// Fenwick tree over times 1..n: add delta at i, prefix sum of 1..i
+static void fen_add(int *tree, long n, long i, int delta) {
+    for (; i <= n; i += i & -i) tree[i] += delta;
+}
+
+static long fen_sum(const int *tree, long i) {
+    long sum = 0;
+    for (; i > 0; i -= i & -i) sum += tree[i];
+    return sum;
+}
+
+// renumber the live access times 1..distinct in order, in place, and
+// widen the clock to twice the distinct pages if it has less room than
+// that; return 0 or -1 if out of memory
+static int sdist_compact(sdist_t *sd) {
+    long live = 0;
+    for (long t = 1; t <= sd->now; ++t) {
+        unsigned slot = pmap_slot(&sd->last, sd->at[t]);
+        if (sd->last.vals[slot] != t) continue;
+        sd->at[++live] = sd->at[t];
+        sd->last.vals[slot] = live;
+    }
+    sd->now = live;
+    if (2 * live > sd->cap) {
+        long cap = 2 * live;
+        int *tree = (int *)realloc(sd->tree, ((size_t)cap + 1) * sizeof(int));
+        if (tree) sd->tree = tree;
+        page_t *at = (page_t *)realloc(sd->at, ((size_t)cap + 1) * sizeof(page_t));
+        if (at) sd->at = at;
+        if (!tree || !at) return -1;
+        sd->cap = cap;
+    }
+    // node i covers times (i - lowbit(i), i]; times 1..live are set
+    for (long i = 1; i <= sd->cap; ++i) {
+        long lo = i - (i & -i);
+        sd->tree[i] = (int)(live > lo ? (live < i ? live : i) - lo : 0);
+    }
+    return 0;
+}
+
+// one reference to page by the process; return 0 or -1 if out of memory
+static int sdist_access(sdist_t *sd, page_t page) {
+    if (sd->now == sd->cap && sdist_compact(sd) != 0) return -1;
+    long t = ++sd->now;
+    sd->refs++;
+    unsigned slot = pmap_slot(&sd->last, page);
+    long prev = sd->last.vals[slot];
+    if (prev >= 0) {
+        long dist = fen_sum(sd->tree, t - 1) - fen_sum(sd->tree, prev) + 1;
+        sd->hist[dist]++;
+        fen_add(sd->tree, sd->cap, prev, -1);
+    }
+    fen_add(sd->tree, sd->cap, t, 1);
+    sd->at[t] = page;
+    if (pmap_put(&sd->last, page, t) != 0) return -1;
+    // distances never exceed the distinct pages seen
+    if (sd->last.count + 1 >= sd->hist_cap) {
+        long cap = 2 * sd->hist_cap;
+        long *hist = (long *)realloc(sd->hist, (size_t)cap * sizeof(long));
+        if (!hist) return -1;
+        memset(hist + sd->hist_cap, 0, (size_t)(cap - sd->hist_cap) * sizeof(long));
+        sd->hist = hist;
+        sd->hist_cap = cap;
+    }
+    return 0;
+}
+
+// one streamed pass over the trace: a page's LRU stack distance is the
+// number of distinct pages touched since its last access, plus one.
+// Each process marks the time of every page's latest access in a
+// Fenwick tree, so the distinct count is a range sum; LRU with F frames
+// hits exactly the references with distance <= F. Memory follows the
+// distinct pages, not the trace length. Fills hist[p][d] (d =
+// 1..distinct[p], caller frees), refs and distinct page counts; returns
+// 0 or 1.
+static int stack_histograms(const char *datafile, long refs[PROCS], long distinct[PROCS],
+                            long *hist[PROCS]) {
+    FILE *fp = fopen(datafile, "r");
+    if (!fp) {
+        perror("fopen");
+        return 1;
+    }
+    sdist_t sd[PROCS];
+    int rc = 0;
+    memset(sd, 0, sizeof(sd));
+    for (int p = 0; p < PROCS && rc == 0; ++p) {
+        sd[p].cap = 1024;
+        sd[p].hist_cap = 1024;
+        sd[p].tree = (int *)calloc((size_t)sd[p].cap + 1, sizeof(int));
+        sd[p].at = (page_t *)malloc(((size_t)sd[p].cap + 1) * sizeof(page_t));
+        sd[p].hist = (long *)calloc((size_t)sd[p].hist_cap, sizeof(long));
+        if (!sd[p].tree || !sd[p].at || !sd[p].hist || pmap_init(&sd[p].last, 1024) != 0)
+            rc = 1;
+    }
+
+    char line[MAX_LINE];
+    long n = 0;
+    while (rc == 0 && fgets(line, sizeof(line), fp)) {
+        if (line[0] == '\n' || line[0] == '\r' || line[0] == '#') continue;
+        long long proc = 0;
+        page_t page = 0;
+        if (sscanf(line, "%lld %lld", &proc, &page) != 2) continue;
+        if (proc < 1 || proc > PROCS) continue;
+        if (sdist_access(&sd[proc - 1], page) != 0) rc = 1;
+        n++;
+    }
+    fclose(fp);
+    if (rc != 0) {
+        perror("malloc");
+    } else if (n == 0) {
+        fprintf(stderr, "no references in %s\n", datafile);
+        rc = 1;
+    }
+
+    for (int p = 0; p < PROCS; ++p) {
+        refs[p] = sd[p].refs;
+        distinct[p] = sd[p].last.count;
+        if (rc == 0) {
+            hist[p] = sd[p].hist;
+        } else {
+            free(sd[p].hist);
+            hist[p] = NULL;
+        }
+        free(sd[p].tree);
+        free(sd[p].at);
+        pmap_free(&sd[p].last);
+    }
+    return rc;
+}
+
+// print every process's hit rate for 0..max_frames frames
+static int curve(const char *datafile, long max_frames) {
+    long refs[PROCS], distinct[PROCS];
+    long *hist[PROCS];
+    if (stack_histograms(datafile, refs, distinct, hist) != 0) return 1;
+
+    long top = max_frames;
+    if (top < 0) {
+        top = 0;
+        for (int p = 0; p < PROCS; ++p)
+            if (distinct[p] > top) top = distinct[p];
+    }
+    long hits[PROCS] = {0, 0, 0, 0};
+    printf("%6s %8s %8s %8s %8s\n", "frames", "P1", "P2", "P3", "P4");
+    for (long f = 0; f <= top; ++f) {
+        printf("%6ld", f);
+        for (int p = 0; p < PROCS; ++p) {
+            if (f > 0 && f <= distinct[p]) hits[p] += hist[p][f];
+            printf(" %7.2f%%", refs[p] > 0 ? 100.0 * (double)hits[p] / (double)refs[p] : 0.0);
+        }
+        printf("\n");
+    }
+    for (int p = 0; p < PROCS; ++p) free(hist[p]);
+    return 0;
+}
+
+// steepest edges first; ties keep process order
+static int cmp_edge(const void *a, const void *b) {
+    const hull_edge_t *x = (const hull_edge_t *)a, *y = (const hull_edge_t *)b;
+    if (x->slope != y->slope) return x->slope < y->slope ? 1 : -1;
+    return x->proc - y->proc;
+}
+
+// upper concave hull of y[0..n] as edges appended to out; returns count
+static int concave_hull(const double *y, long n, int proc, hull_edge_t *out) {
+    long *stack = (long *)malloc((size_t)(n + 1) * sizeof(long));
+    if (!stack) return -1;
+    long top = 0;
+    stack[0] = 0;
+    for (long x = 1; x <= n; ++x) {
+        // pop while the last point lies on or under the chord to x
+        while (top > 0) {
+            long a = stack[top - 1], b = stack[top];
+            if ((y[b] - y[a]) * (double)(x - a) > (y[x] - y[a]) * (double)(b - a)) break;
+            top--;
+        }
+        stack[++top] = x;
+    }
+    for (long i = 0; i < top; ++i) {
+        long a = stack[i], b = stack[i + 1];
+        out[i].proc = proc;
+        out[i].len = (int)(b - a);
+        out[i].slope = (y[b] - y[a]) / (double)(b - a);
+    }
+    free(stack);
+    return (int)top;
+}
+
+// best split of every budget up to 'budget' frames for the weighted mean
+// hit rate (weights NULL: weight by references). Exact DP over the
+// processes: best_k(b) = max over x of best_{k-1}(b - x) + v_k(x). Past
+// ALLOC_DP_MAX frames it walks the processes' concave-hull edges from
+// steepest down, which is optimal at every hull breakpoint and close to
+// it in between.
+static int allocate(const char *datafile, long budget, const double *weights) {
+    long refs[PROCS], distinct[PROCS];
+    long *hist[PROCS];
+    if (stack_histograms(datafile, refs, distinct, hist) != 0) return 1;
+
+    double w[PROCS], wsum = 0.0;
+    for (int p = 0; p < PROCS; ++p) {
+        w[p] = weights ? weights[p] : (double)refs[p];
+        wsum += w[p];
+    }
+    if (wsum <= 0.0) wsum = 1.0;
+
+    // rate[p][x]: process p's hit rate with x frames, v[p][x] its share
+    // of the objective
+    size_t row = (size_t)budget + 1;
+    double *rate = (double *)malloc(PROCS * row * sizeof(double));
+    double *v = (double *)malloc(PROCS * row * sizeof(double));
+    double *best = (double *)malloc(PROCS * row * sizeof(double));
+    int *choice = (int *)malloc(PROCS * row * sizeof(int));
+    int *split = (int *)malloc(row * PROCS * sizeof(int));
+    if (!rate || !v || !best || !choice || !split) {
+        perror("malloc");
+        free(rate);
+        free(v);
+        free(best);
+        free(choice);
+        free(split);
+        for (int p = 0; p < PROCS; ++p) free(hist[p]);
+        return 1;
+    }
+    for (int p = 0; p < PROCS; ++p) {
+        long hits = 0;
+        for (long x = 0; x <= budget; ++x) {
+            if (x > 0 && x <= distinct[p]) hits += hist[p][x];
+            rate[p * row + x] = refs[p] > 0 ? (double)hits / (double)refs[p] : 0.0;
+            v[p * row + x] = w[p] * rate[p * row + x] / wsum;
+        }
+        free(hist[p]);
+    }
+
+    double t0 = now_sec();
+    int exact = budget <= ALLOC_DP_MAX;
+    if (exact) {
+        for (long b = 0; b <= budget; ++b) {
+            best[b] = v[b];
+            choice[b] = (int)b;
+        }
+        for (int k = 1; k < PROCS; ++k) {
+            const double *prev = best + (size_t)(k - 1) * row;
+            const double *vk = v + (size_t)k * row;
+            for (long b = 0; b <= budget; ++b) {
+                double top = -1.0;
+                int arg = 0;
+                for (long x = 0; x <= b; ++x) {
+                    double val = prev[b - x] + vk[x];
+                    if (val > top) {
+                        top = val;
+                        arg = (int)x;
+                    }
+                }
+                best[(size_t)k * row + b] = top;
+                choice[(size_t)k * row + b] = arg;
+            }
+        }
+        for (long b = 0; b <= budget; ++b) {
+            long left = b;
+            for (int k = PROCS - 1; k >= 0; --k) {
+                int x = choice[(size_t)k * row + left];
+                split[b * PROCS + k] = x;
+                left -= x;
+            }
+        }
+    } else {
+        hull_edge_t *edges = (hull_edge_t *)malloc(PROCS * row * sizeof(hull_edge_t));
+        int n_edges = 0;
+        for (int p = 0; p < PROCS && edges; ++p) {
+            int got = concave_hull(v + (size_t)p * row, budget, p, edges + n_edges);
+            if (got < 0) {
+                free(edges);
+                edges = NULL;
+            } else {
+                n_edges += got;
+            }
+        }
+        if (!edges) {
+            perror("malloc");
+            free(rate);
+            free(v);
+            free(best);
+            free(choice);
+            free(split);
+            return 1;
+        }
+        qsort(edges, (size_t)n_edges, sizeof(hull_edge_t), cmp_edge);
+        int cur[PROCS] = {0, 0, 0, 0};
+        int e = 0, used = 0;
+        for (long b = 0; b <= budget; ++b) {
+            if (b > 0 && e < n_edges) {
+                cur[edges[e].proc]++;
+                if (++used == edges[e].len) {
+                    e++;
+                    used = 0;
+                }
+            }
+            memcpy(split + b * PROCS, cur, sizeof(cur));
+        }
+        free(edges);
+    }
+    double ms = (now_sec() - t0) * 1000.0;
+
+    // optimum, in the simulator's output format, then the Pareto table
+    const int *opt = split + budget * PROCS;
+    double pct[PROCS], avg = 0.0, obj = 0.0;
+    for (int p = 0; p < PROCS; ++p) {
+        pct[p] = 100.0 * rate[p * row + opt[p]];
+        avg += pct[p];
+        obj += 100.0 * v[p * row + opt[p]];
+    }
+    avg /= PROCS;
+    printf("budget %ld frames, weights", budget);
+    for (int p = 0; p < PROCS; ++p) printf(" %g", w[p]);
+    printf(", %s in %.3f ms\n", exact ? "exact DP" : "concave-hull greedy", ms);
+    printf("optimal: %2d %2d %2d %2d  ->  P1=%d%%  P2=%d%%  P3=%d%%  P4=%d%%  AVG=%d%%  "
+           "objective=%.2f%%\n", opt[0], opt[1], opt[2], opt[3],
+           (int)(pct[0] + 0.5), (int)(pct[1] + 0.5), (int)(pct[2] + 0.5), (int)(pct[3] + 0.5),
+           (int)(avg + 0.5), obj);
+    printf("%6s %6s %6s %6s %6s %10s\n", "frames", "P1", "P2", "P3", "P4", "objective");
+    for (long b = 0; b <= budget; ++b) {
+        const int *sp = split + b * PROCS;
+        double o = 0.0;
+        for (int p = 0; p < PROCS; ++p) o += v[p * row + sp[p]];
+        printf("%6ld %6d %6d %6d %6d %9.2f%%\n", b, sp[0], sp[1], sp[2], sp[3], 100.0 * o);
+    }
+
+    free(rate);
+    free(v);
+    free(best);
+    free(choice);
+    free(split);
+    return 0;
+}
+
+// print "P1=..%  P2=..%  P3=..%  P4=..%  AVG=..%" (no newline)
+static void print_rates(const long hits[PROCS], const long refs[PROCS]) {
+    double pct[PROCS];
+    double avg = 0.0;
+    for (int i = 0; i < PROCS; ++i) {
+        pct[i] = (refs[i] > 0) ? (100.0 * (double)hits[i] / (double)refs[i]) : 0.0;
+        avg += pct[i];
+    }
+    avg /= PROCS;
+    printf("P1=%d%%  P2=%d%%  P3=%d%%  P4=%d%%  AVG=%d%%",
+           (int)(pct[0] + 0.5), (int)(pct[1] + 0.5),
+           (int)(pct[2] + 0.5), (int)(pct[3] + 0.5),
+           (int)(avg + 0.5));
+}
+
+// OPT's oracle: for each reference, the index of the same process's
+// next reference to the same page (LONG_MAX if none), from one backward
+// scan; caller frees
+static long *next_uses(const int *procs, const page_t *pages, long n) {
+    long *next = (long *)malloc((size_t)n * sizeof(long));
+    pmap_t seen[PROCS];
+    int rc = next ? 0 : -1;
+    memset(seen, 0, sizeof(seen));
+    for (int p = 0; p < PROCS && rc == 0; ++p) rc = pmap_init(&seen[p], 1024);
+    for (long i = n - 1; i >= 0 && rc == 0; --i) {
+        pmap_t *m = &seen[procs[i]];
+        long later = m->vals[pmap_slot(m, pages[i])];
+        next[i] = later >= 0 ? later : LONG_MAX;
+        rc = pmap_put(m, pages[i], i);
+    }
+    for (int p = 0; p < PROCS; ++p) pmap_free(&seen[p]);
+    if (rc != 0) {
+        perror("malloc");
+        free(next);
+        return NULL;
+    }
+    return next;
+}
+
+// replay the trace under one policy; the replay is repeated from a cold
+// start until min_refs references have been timed, and the hit rates
+// (the same every pass) and refs/s are printed
+static int run_policy(const policy_t *pol, const int *procs, const page_t *pages,
+                      const long *next, long n, const int caps[PROCS], long min_refs) {
+    long passes = (min_refs + n - 1) / n;
+    long hits[PROCS], refs[PROCS];
+    double secs = 0.0;
+    for (long r = 0; r < passes; ++r) {
+        void *st[PROCS] = {0};
+        int resident[PROCS] = {0};
+        int rc = 0;
+        for (int p = 0; p < PROCS; ++p) {
+            hits[p] = refs[p] = 0;
+            if (caps[p] > 0 && !(st[p] = pol->init(caps[p]))) rc = 1;
+        }
+        if (rc == 0) {
+            double t0 = now_sec();
+            for (long i = 0; i < n; ++i) {
+                int p = procs[i];
+                refs[p]++;
+                // a process with no frames misses every time
+                if (st[p])
+                    hits[p] += policy_ref(pol, st[p], caps[p], &resident[p], pages[i], next[i]);
+            }
+            secs += now_sec() - t0;
+        }
+        for (int p = 0; p < PROCS; ++p)
+            if (st[p]) pol->destroy(st[p]);
+        if (rc != 0) {
+            perror("malloc");
+            return 1;
+        }
+    }
+    printf("%-9s ", pol->name);
+    print_rates(hits, refs);
+    printf("  %12.0f refs/s\n", secs > 0.0 ? (double)passes * (double)n / secs : 0.0);
+    return 0;
+}
+
+// --policy: run the named policy (or all of them) with the given frames
+static int compare_policies(const char *name, const char *datafile, const int caps[PROCS]) {
+    int which = -1;
+    for (int k = 0; k < NUM_POLICIES; ++k)
+        if (strcmp(name, policies[k].name) == 0) which = k;
+    if (which < 0 && strcmp(name, "all") != 0) {
+        fprintf(stderr, "unknown policy '%s'; one of:", name);
+        for (int k = 0; k < NUM_POLICIES; ++k) fprintf(stderr, " %s", policies[k].name);
+        fprintf(stderr, " all\n");
+        return 1;
+    }
+
+    int *procs = NULL;
+    page_t *pages = NULL;
+    long n = load_trace(datafile, &procs, &pages);
+    if (n < 0) return 1;
+    long *next = next_uses(procs, pages, n);
+    int rc = next ? 0 : 1;
+    for (int k = 0; k < NUM_POLICIES && rc == 0; ++k)
+        if (which < 0 || which == k)
+            rc = run_policy(&policies[k], procs, pages, next, n, caps, BENCH_MIN_REFS);
+    free(next);
+    free(procs);
+    free(pages);
+    return rc;
+}
+
+// empty table with room for a few processes; return 0 or -1
+static int ptable_init(ptable_t *t) {
+    t->count = 0;
+    t->cap = 16;
+    t->mask = 31;
+    t->procs = (proc_t *)malloc((size_t)t->cap * sizeof(proc_t));
+    t->table = (int *)malloc((t->mask + 1) * sizeof(int));
+    if (!t->procs || !t->table) {
+        free(t->procs);
+        free(t->table);
+        t->procs = NULL;
+        t->table = NULL;
+        return -1;
+    }
+    memset(t->table, 0xff, (t->mask + 1) * sizeof(int));
+    return 0;
+}
+
+static void ptable_free(ptable_t *t, const policy_t *pol) {
+    for (int i = 0; i < t->count; ++i)
+        if (t->procs[i].st) pol->destroy(t->procs[i].st);
+    free(t->procs);
+    free(t->table);
+    t->procs = NULL;
+    t->table = NULL;
+}
+
+// slot holding pid, or the empty slot where it would go
+static unsigned ptable_slot(const ptable_t *t, long long pid) {
+    unsigned slot = page_hash((page_t)pid) & t->mask;
+    while (t->table[slot] >= 0 && t->procs[t->table[slot]].pid != pid)
+        slot = (slot + 1) & t->mask;
+    return slot;
+}
+
+// pid's process, NULL if it never made a reference
+static proc_t *ptable_find(const ptable_t *t, long long pid) {
+    int i = t->table[ptable_slot(t, pid)];
+    return i >= 0 ? &t->procs[i] : NULL;
+}
+
+// pid's process, created with 'frames' frames under pol on first
+// sight; NULL if out of memory
+static proc_t *ptable_get(ptable_t *t, long long pid, int frames, const policy_t *pol) {
+    unsigned slot = ptable_slot(t, pid);
+    if (t->table[slot] >= 0) return &t->procs[t->table[slot]];
+
+    if (t->count == t->cap) {
+        proc_t *np = (proc_t *)realloc(t->procs, 2 * (size_t)t->cap * sizeof(proc_t));
+        if (!np) return NULL;
+        t->procs = np;
+        t->cap *= 2;
+    }
+    // keep the table at most half full
+    if (2u * (unsigned)(t->count + 1) > t->mask + 1) {
+        unsigned size = 2 * (t->mask + 1);
+        int *nt = (int *)malloc(size * sizeof(int));
+        if (!nt) return NULL;
+        memset(nt, 0xff, size * sizeof(int));
+        free(t->table);
+        t->table = nt;
+        t->mask = size - 1;
+        for (int i = 0; i < t->count; ++i) t->table[ptable_slot(t, t->procs[i].pid)] = i;
+        slot = ptable_slot(t, pid);
+    }
+
+    proc_t *p = &t->procs[t->count];
+    p->pid = pid;
+    p->frames = frames;
+    p->refs = p->hits = 0;
+    p->resident = 0;
+    p->st = NULL;
+    if (frames > 0 && !(p->st = pol->init(frames))) return NULL;
+    t->table[slot] = t->count++;
+    return p;
+}
+
+// frames for pid: its config entry, else the default rule
+static int cfg_frames(const alloc_cfg_t *cfg, long long pid) {
+    int lo = 0, hi = cfg->count - 1;
+    while (lo <= hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (cfg->entries[mid].pid == pid) return cfg->entries[mid].frames;
+        if (cfg->entries[mid].pid < pid) lo = mid + 1;
+        else hi = mid - 1;
+    }
+    return cfg->dflt;
+}
+
+static int cmp_entry(const void *a, const void *b) {
+    long long x = ((const alloc_entry_t *)a)->pid, y = ((const alloc_entry_t *)b)->pid;
+    return (x > y) - (x < y);
+}
+
+// read an allocation file: "<pid> <frames>" lines and an optional
+// "default <frames>" line for every other PID (0 if absent); blank
+// lines and '#' comments are skipped. Return 0 or -1 after saying why.
+static int load_alloc_cfg(const char *path, alloc_cfg_t *cfg) {
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        perror("fopen");
+        return -1;
+    }
+    cfg->entries = NULL;
+    cfg->count = 0;
+    cfg->dflt = 0;
+    int cap = 0, lineno = 0, rc = 0;
+    char line[MAX_LINE];
+    while (rc == 0 && fgets(line, sizeof(line), fp)) {
+        lineno++;
+        char word[32];
+        long long pid;
+        int frames;
+        if (sscanf(line, " %31s", word) != 1 || word[0] == '#') continue;
+        if (strcmp(word, "default") == 0 && sscanf(line, " default %d", &frames) == 1) {
+            cfg->dflt = frames;
+        } else if (sscanf(line, "%lld %d", &pid, &frames) == 2) {
+            if (cfg->count == cap) {
+                cap = cap ? cap * 2 : 64;
+                alloc_entry_t *ne = (alloc_entry_t *)realloc(cfg->entries,
+                                                             (size_t)cap * sizeof(alloc_entry_t));
+                if (!ne) {
+                    perror("realloc");
+                    rc = -1;
+                    break;
+                }
+                cfg->entries = ne;
+            }
+            cfg->entries[cfg->count].pid = pid;
+            cfg->entries[cfg->count].frames = frames;
+            cfg->count++;
+        } else {
+            fprintf(stderr, "%s:%d: expected \"<pid> <frames>\" or \"default <frames>\"\n",
+                    path, lineno);
+            rc = -1;
+        }
+        if (rc == 0 && frames < 0) {
+            fprintf(stderr, "%s:%d: frame counts must be non-negative\n", path, lineno);
+            rc = -1;
+        }
+    }
+    fclose(fp);
+    if (rc == 0) {
+        qsort(cfg->entries, (size_t)cfg->count, sizeof(alloc_entry_t), cmp_entry);
+        for (int i = 1; i < cfg->count; ++i) {
+            if (cfg->entries[i].pid == cfg->entries[i - 1].pid) {
+                fprintf(stderr, "%s: pid %lld listed twice\n", path, cfg->entries[i].pid);
+                rc = -1;
+                break;
+            }
+        }
+    }
+    if (rc != 0) {
+        free(cfg->entries);
+        cfg->entries = NULL;
+    }
+    return rc;
+}
+
+// stream the trace through per-PID processes under pol, each given its
+// frames from cfg on its first reference; return 0 or 1
+static int simulate(const char *datafile, const alloc_cfg_t *cfg, const policy_t *pol,
+                    ptable_t *t) {
+    FILE *fp = fopen(datafile, "r");
+    if (!fp) {
+        perror("fopen");
+        return 1;
+    }
+    if (ptable_init(t) != 0) {
+        perror("malloc");
+        fclose(fp);
+        return 1;
+    }
+    char line[MAX_LINE];
+    while (fgets(line, sizeof(line), fp)) {
+        if (line[0] == '\n' || line[0] == '\r' || line[0] == '#') continue;
+        long long pid = 0;
+        page_t page = 0;
+        if (sscanf(line, "%lld %lld", &pid, &page) != 2) continue;
+        proc_t *p = ptable_find(t, pid);
+        if (!p && !(p = ptable_get(t, pid, cfg_frames(cfg, pid), pol))) {
+            perror("malloc");
+            fclose(fp);
+            ptable_free(t, pol);
+            return 1;
+        }
+        p->refs++;
+        // a process with no frames misses every time
+        if (p->st) p->hits += policy_ref(pol, p->st, p->frames, &p->resident, page, LONG_MAX);
+    }
+    fclose(fp);
+    return 0;
+}
+
+static int cmp_pid(const void *a, const void *b) {
+    long long x = ((const proc_t *)a)->pid, y = ((const proc_t *)b)->pid;
+    return (x > y) - (x < y);
+}
+
+// --procs: every PID in the trace with frames from a config file or a
+// fixed count, one line per process in PID order, then the totals
+static int run_procs(const char *datafile, const char *alloc, const char *policy) {
+    const policy_t *pol = NULL;
+    for (int k = 0; k < NUM_POLICIES; ++k)
+        if (strcmp(policy, policies[k].name) == 0) pol = &policies[k];
+    if (!pol || strcmp(policy, "opt") == 0) {
+        // OPT needs the whole trace up front; --policy covers it
+        fprintf(stderr, "unknown or unsupported policy '%s' for --procs\n", policy);
+        return 1;
+    }
+
+    alloc_cfg_t cfg = { NULL, 0, 0 };
+    char *end;
+    long frames = strtol(alloc, &end, 10);
+    if (*alloc != '\0' && *end == '\0') {
+        if (frames < 0 || frames > INT_MAX) {
+            fprintf(stderr, "Frame counts must be non-negative.\n");
+            return 1;
+        }
+        cfg.dflt = (int)frames;
+    } else if (load_alloc_cfg(alloc, &cfg) != 0) {
+        return 1;
+    }
+
+    ptable_t t;
+    int rc = simulate(datafile, &cfg, pol, &t);
+    free(cfg.entries);
+    if (rc != 0) return 1;
+
+    // the table is not used for lookups after this
+    qsort(t.procs, (size_t)t.count, sizeof(proc_t), cmp_pid);
+    long total_frames = 0, refs = 0, hits = 0;
+    double avg = 0.0;
+    printf("%12s %8s %12s %12s %8s\n", "pid", "frames", "refs", "hits", "hit%");
+    for (int i = 0; i < t.count; ++i) {
+        const proc_t *p = &t.procs[i];
+        double pct = p->refs > 0 ? 100.0 * (double)p->hits / (double)p->refs : 0.0;
+        printf("%12lld %8d %12ld %12ld %7.2f%%\n", p->pid, p->frames, p->refs, p->hits, pct);
+        total_frames += p->frames;
+        refs += p->refs;
+        hits += p->hits;
+        avg += pct;
+    }
+    if (t.count > 0) avg /= t.count;
+    printf("procs=%d  frames=%ld  AVG=%d%%  ALL=%d%%\n", t.count, total_frames, (int)(avg + 0.5),
+           (int)(refs > 0 ? 100.0 * (double)hits / (double)refs + 0.5 : 0.0));
+    ptable_free(&t, pol);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc >= 3 && argc <= 4 && strcmp(argv[1], "--bench") == 0) {
+        long min_refs = argc == 4 ? atol(argv[3]) : BENCH_MIN_REFS;
+        if (min_refs <= 0) {
+            usage(argv[0]);
+            return 1;
+        }
+        return bench(argv[2], min_refs);
+    }
+    if (argc >= 3 && argc <= 4 && strcmp(argv[1], "--curve") == 0) {
+        long max_frames = argc == 4 ? atol(argv[3]) : -1;
+        if (argc == 4 && max_frames < 0) {
+            usage(argv[0]);
+            return 1;
+        }
+        return curve(argv[2], max_frames);
+    }
+    if ((argc == 4 || argc == 5 || argc == 8) && strcmp(argv[1], "--allocate") == 0) {
+        long budget = atol(argv[3]);
+        double weights[PROCS] = {1.0, 1.0, 1.0, 1.0};
+        int by_refs = argc == 5 && strcmp(argv[4], "refs") == 0;
+        if (argc == 8) {
+            for (int p = 0; p < PROCS; ++p) {
+                weights[p] = atof(argv[4 + p]);
+                if (weights[p] < 0.0) budget = -1;
+            }
+        }
+        if (budget < 0 || budget > INT_MAX || (argc == 5 && !by_refs)) {
+            usage(argv[0]);
+            return 1;
+        }
+        return allocate(argv[2], budget, by_refs ? NULL : weights);
+    }
+    if ((argc == 4 || argc == 5) && strcmp(argv[1], "--procs") == 0)
+        return run_procs(argv[2], argv[3], argc == 5 ? argv[4] : "lru");
+    if (argc == 8 && strcmp(argv[1], "--policy") == 0) {
+        int caps[PROCS];
+        for (int i = 0; i < PROCS; ++i) {
+            caps[i] = atoi(argv[4 + i]);
+            if (caps[i] < 0) {
+                fprintf(stderr, "Frame counts must be non-negative.\n");
+                return 1;
+            }
+        }
+        return compare_policies(argv[2], argv[3], caps);
+    }
+    if (argc != 6) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    const char *datafile = argv[1];
+
+    // Get frame counts for each process; PIDs 1-4 get them and any
+    // other PID in the trace gets none
+    alloc_entry_t caps[PROCS];
+    alloc_cfg_t cfg = { caps, PROCS, 0 };
+    for (int i = 0; i < PROCS; ++i) {
+        caps[i].pid = i + 1;
+        caps[i].frames = atoi(argv[2 + i]);
+        if (caps[i].frames < 0) {
+            fprintf(stderr, "Frame counts must be non-negative.\n");
+            return 1;
+        }
+    }
+
+    // run the trace through an LRU per process
+    const policy_t *lru = &policies[0];
+    ptable_t t;
+    if (simulate(datafile, &cfg, lru, &t) != 0) return 1;
+
+    // collect hit and reference counters
+    long hits[PROCS] = {0,0,0,0};
+    long refs[PROCS] = {0,0,0,0};
+    for (int i = 0; i < PROCS; ++i) {
+        const proc_t *p = ptable_find(&t, i + 1);
+        if (p) {
+            hits[i] = p->hits;
+            refs[i] = p->refs;
+        }
+    }
+
+    // Print results
+    print_rates(hits, refs);
+    printf("\n");
 
     // clean up
-    for (int p = 0; p < PROCS; ++p)
-        free(bufs[p]);
+    ptable_free(&t, lru);
 
     return 0;
 }
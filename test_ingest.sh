@@ -0,0 +1,39 @@
+#!/bin/bash
+# Regression checks for the shared DNA reader: a '>' only opens a FASTA
+# header at the start of a line, so plain sequences that contain one
+# mid-line keep every base after it. Exits 1 on the first failure.
+# Usage: ./test_ingest.sh
+# Compile first:
+#   gcc -Wall -O2 prog2.c dna_ingest.c -o prog2 -lpthread
+#   gcc -Wall -O2 prog2a.c dna_ingest.c -o prog2a -lpthread
+dir=$(mktemp -d /tmp/dna_test_XXXXXX)
+trap 'rm -rf "$dir"' EXIT
+fail=0
+
+# check <label> <expected count> <command...>
+check() {
+  local label=$1 want=$2 got
+  shift 2
+  got=$("$@" 2> /dev/null | awk '/Best Match Count/ { print $4 }')
+  if [ "$got" = "$want" ]; then
+    echo "ok   $label"
+  else
+    echo "FAIL $label: count '$got', expected $want"
+    fail=1
+  fi
+}
+
+# Mid-line '>': all 20 bases are sequence, the pattern matches in full
+printf 'ACGTACGT>ACGTACGT\nTTTT\n' > "$dir/midline.txt"
+printf 'ACGTACGTACGT\n' > "$dir/pat.txt"
+check "prog2 mid-line '>'" 12 ./prog2 "$dir/midline.txt" "$dir/pat.txt" 1
+check "prog2a mid-line '>'" 12 ./prog2a "$dir/midline.txt" "$dir/pat.txt" 1
+mkdir "$dir/db" && cp "$dir/midline.txt" "$dir/db/"
+check "prog2 --db mid-line '>'" 12 ./prog2 --db "$dir/db" "$dir/pat.txt" 1
+
+# A real header line is still skipped: only TTTTACGT remains
+printf '>rec ACGTACGTACGT\nTTTTACGT\n' > "$dir/header.fa"
+printf 'ACGTACGT\n' > "$dir/pat8.txt"
+check "prog2 header line" 5 ./prog2 "$dir/header.fa" "$dir/pat8.txt" 1
+
+exit $fail
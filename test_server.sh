@@ -0,0 +1,48 @@
+#!/bin/bash
+# Regression check for prog2 --serve: with several pool workers, every
+# query answered through --client must give the same best position and
+# count as a one-shot run over the same files. Exits 1 on a mismatch.
+# Usage: ./test_server.sh
+# Compile first: gcc -Wall -O2 prog2.c dna_ingest.c -o prog2 -lpthread
+dir=$(mktemp -d /tmp/dna_test_XXXXXX)
+sock=$dir/prog2.sock
+server=
+trap '[ -n "$server" ] && kill -INT "$server" 2> /dev/null; rm -rf "$dir"' EXIT
+fail=0
+queries=20
+
+# Random 20 kb sequence and 24-base pattern, same on every run
+awk 'BEGIN { srand(11); for (i = 0; i < 20000; i++) printf "%s", substr("ACGT", int(rand() * 4) + 1, 1); print "" }' > "$dir/seq.txt"
+awk 'BEGIN { srand(12); for (i = 0; i < 24; i++) printf "%s", substr("ACGT", int(rand() * 4) + 1, 1); print "" }' > "$dir/pat.txt"
+
+# "<position> <count>" from prog2 output on stdin
+best() {
+  awk '/Best Match Position/ { p = $4 } /Best Match Count/ { c = $4 } END { print p, c }'
+}
+
+for procs in 4 8; do
+  want=$(./prog2 "$dir/seq.txt" "$dir/pat.txt" "$procs" 2> /dev/null | best)
+
+  rm -f "$sock"
+  ./prog2 --serve "$dir/seq.txt" "$sock" "$procs" 2> /dev/null &
+  server=$!
+  while [ ! -S "$sock" ]; do sleep 0.05; done
+
+  bad=0
+  for ((i = 0; i < queries; i++)); do
+    got=$(./prog2 --client "$sock" "$dir/pat.txt" 1 2> /dev/null | best)
+    if [ "$got" != "$want" ]; then
+      echo "FAIL --serve $procs workers, query $i: got '$got', expected '$want'"
+      bad=1
+      fail=1
+      break
+    fi
+  done
+  [ $bad -eq 0 ] && echo "ok   --serve $procs workers matches one-shot ($queries queries)"
+
+  kill -INT "$server"
+  wait "$server"
+  server=
+done
+
+exit $fail